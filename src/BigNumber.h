@@ -10,3 +10,5 @@
 #pragma once
 
 #include "BigNumber/BigNumber.h"
+#include "BigNumber/BigUInt.h"
+#include "BigNumber/BigFixed.h"
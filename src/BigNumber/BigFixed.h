@@ -0,0 +1,172 @@
+//
+//  BigFixed.h
+//
+//  Fixed point decimals, with the number of decimal places fixed when
+//  compiling.
+//  Released into the public domain.
+//
+//  A BigFixed<Scale> is kept as the integer value * 10^Scale, in a
+//  BigInt<Bits> (see BigUInt.h), so there is no heap and no scale to work
+//  out at run time: adding, subtracting and comparing are integer
+//  operations, and multiplying or dividing are an integer operation at
+//  twice the width and a division or multiplication by the constant
+//  10^Scale.  Results are truncated towards zero, as with BigNumber, and
+//  wrap around if they do not fit in Bits bits (the default, 128, holds
+//  about 38 digits, eg. 20 before the point and 18 after).  Dividing by
+//  zero gives zero.
+
+#ifndef _BigFixed_h
+#define _BigFixed_h
+
+#include "BigUInt.h"
+
+template <int Scale, unsigned Bits = 128> class BigFixed
+{
+  static_assert (Scale >= 0, "BigFixed: Scale must not be negative");
+  static_assert (Scale * 3322L / 1000 + 2 < (long) Bits, "BigFixed: 10^Scale does not fit in Bits");
+
+  // the value * 10^Scale
+  BigInt<Bits> raw_;
+
+  static BIGUINT_CONSTEXPR BigUInt<Bits> unit ();
+  static BIGUINT_CONSTEXPR BigFixed withSign (const BigUInt<Bits> & magnitude, const bool negative);
+
+public:
+  // constructors
+  BIGUINT_CONSTEXPR BigFixed () { }
+  BIGUINT_CONSTEXPR BigFixed (const int64_t n) : raw_ (BigInt<Bits> (n) * BigInt<Bits> (unit ())) { }
+  // n, truncated to Scale places
+  explicit BigFixed (const BigNumber & n);
+  explicit BigFixed (const char * s);
+  BigNumber toBigNumber () const;
+
+  // the scaled integer (the value * 10^Scale)
+  static BIGUINT_CONSTEXPR BigFixed fromRaw (const BigInt<Bits> & raw) { BigFixed n; n.raw_ = raw; return n; }
+  BIGUINT_CONSTEXPR const BigInt<Bits> & raw () const { return raw_; }
+
+  // the number, with Scale decimal places, into buf (see
+  // BigNumber::toChars): returns the length, and only writes it if that is
+  // less than cap
+  size_t toChars (char * buf, const size_t cap) const;
+
+  BIGUINT_CONSTEXPR bool isZero () const { return raw_.isZero (); }
+  BIGUINT_CONSTEXPR bool isNegative () const { return raw_.isNegative (); }
+
+  // arithmetic
+  BIGUINT_CONSTEXPR BigFixed operator- () const { return fromRaw (- raw_); }
+  BIGUINT_CONSTEXPR BigFixed operator+ (const BigFixed & n) const { return fromRaw (raw_ + n.raw_); }
+  BIGUINT_CONSTEXPR BigFixed operator- (const BigFixed & n) const { return fromRaw (raw_ - n.raw_); }
+  BIGUINT_CONSTEXPR BigFixed operator* (const BigFixed & n) const;
+  BIGUINT_CONSTEXPR BigFixed operator/ (const BigFixed & n) const;
+  BIGUINT_CONSTEXPR BigFixed & operator+= (const BigFixed & n) { raw_ += n.raw_; return *this; }
+  BIGUINT_CONSTEXPR BigFixed & operator-= (const BigFixed & n) { raw_ -= n.raw_; return *this; }
+  BIGUINT_CONSTEXPR BigFixed & operator*= (const BigFixed & n) { return *this = *this * n; }
+  BIGUINT_CONSTEXPR BigFixed & operator/= (const BigFixed & n) { return *this = *this / n; }
+
+  // comparisons
+  BIGUINT_CONSTEXPR bool operator== (const BigFixed & rhs) const { return raw_ == rhs.raw_; }
+  BIGUINT_CONSTEXPR bool operator!= (const BigFixed & rhs) const { return raw_ != rhs.raw_; }
+  BIGUINT_CONSTEXPR bool operator<  (const BigFixed & rhs) const { return raw_ < rhs.raw_; }
+  BIGUINT_CONSTEXPR bool operator<= (const BigFixed & rhs) const { return raw_ <= rhs.raw_; }
+  BIGUINT_CONSTEXPR bool operator>  (const BigFixed & rhs) const { return raw_ > rhs.raw_; }
+  BIGUINT_CONSTEXPR bool operator>= (const BigFixed & rhs) const { return raw_ >= rhs.raw_; }
+};  // end of class BigFixed
+
+// 10^Scale, nine digits at a time
+template <int Scale, unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigFixed<Scale, Bits>::unit ()
+{
+  BigUInt<Bits> result (1);
+  for (int i = 0; i < Scale / 9; i++)
+    result *= BigUInt<Bits> (1000000000UL);
+  uint32_t rest = 1;
+  for (int i = 0; i < Scale % 9; i++)
+    rest *= 10;
+  return result * BigUInt<Bits> (rest);
+} // end of BigFixed::unit
+
+template <int Scale, unsigned Bits>
+BIGUINT_CONSTEXPR BigFixed<Scale, Bits> BigFixed<Scale, Bits>::withSign (const BigUInt<Bits> & magnitude,
+                                                                        const bool negative)
+{
+  const BigInt<Bits> raw (magnitude);
+  return fromRaw (negative ? - raw : raw);
+} // end of BigFixed::withSign
+
+template <int Scale, unsigned Bits>
+BigFixed<Scale, Bits>::BigFixed (const BigNumber & n)
+{
+  const int oldScale = BigNumber::setScale (0);
+  raw_ = BigInt<Bits> (n * BigNumber (10).pow (BigNumber (Scale)));
+  BigNumber::setScale (oldScale);
+} // end of BigFixed::BigFixed
+
+template <int Scale, unsigned Bits>
+BigFixed<Scale, Bits>::BigFixed (const char * s)
+{
+  const int oldScale = BigNumber::setScale (Scale);
+  *this = BigFixed (BigNumber (s));
+  BigNumber::setScale (oldScale);
+} // end of BigFixed::BigFixed
+
+// the exact value, with a scale of Scale
+template <int Scale, unsigned Bits>
+BigNumber BigFixed<Scale, Bits>::toBigNumber () const
+{
+  const int oldScale = BigNumber::setScale (0);
+  const BigNumber divisor = BigNumber (10).pow (BigNumber (Scale));
+  BigNumber::setScale (Scale);
+  const BigNumber result = raw_.toBigNumber () / divisor;
+  BigNumber::setScale (oldScale);
+  return result;
+} // end of BigFixed::toBigNumber
+
+// the digits of the scaled integer, with the point put in
+template <int Scale, unsigned Bits>
+size_t BigFixed<Scale, Bits>::toChars (char * buf, const size_t cap) const
+{
+  char digits [Bits * 30103UL / 100000 + 2];
+  const size_t count = raw_.magnitude ().toChars (digits, sizeof digits);
+  const size_t whole = count > (size_t) Scale ? count - Scale : 0;
+  const size_t length = isNegative () + (whole > 0 ? whole : 1) + (Scale > 0 ? 1 + Scale : 0);
+  if (length >= cap || buf == NULL)
+    return length;
+
+  char * p = buf;
+  if (isNegative ())
+    *p++ = '-';
+  if (whole == 0)
+    *p++ = '0';
+  for (size_t i = 0; i < whole; i++)
+    *p++ = digits [i];
+  if (Scale > 0)
+    {
+    *p++ = '.';
+    for (size_t i = count - whole; i < (size_t) Scale; i++)
+      *p++ = '0';
+    for (size_t i = whole; i < count; i++)
+      *p++ = digits [i];
+    }
+  *p = 0;
+  return length;
+} // end of BigFixed::toChars
+
+// the full product of the scaled integers, divided by 10^Scale
+template <int Scale, unsigned Bits>
+BIGUINT_CONSTEXPR BigFixed<Scale, Bits> BigFixed<Scale, Bits>::operator* (const BigFixed & n) const
+{
+  const BigUInt<Bits * 2> product = raw_.magnitude ().mulWide (n.raw_.magnitude ());
+  const BigUInt<Bits> magnitude (product / BigUInt<Bits * 2> (unit ()));
+  return withSign (magnitude, isNegative () != n.isNegative ());
+} // end of BigFixed::operator*
+
+// the scaled dividend times 10^Scale, divided by the scaled divisor
+template <int Scale, unsigned Bits>
+BIGUINT_CONSTEXPR BigFixed<Scale, Bits> BigFixed<Scale, Bits>::operator/ (const BigFixed & n) const
+{
+  const BigUInt<Bits * 2> dividend = raw_.magnitude ().mulWide (unit ());
+  const BigUInt<Bits> magnitude (dividend / BigUInt<Bits * 2> (n.raw_.magnitude ()));
+  return withSign (magnitude, isNegative () != n.isNegative ());
+} // end of BigFixed::operator/
+
+#endif
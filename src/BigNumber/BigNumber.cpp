@@ -11,7 +11,11 @@
 
 #include "BigNumber.h"
 
+#if BIGNUMBER_THREADS
+thread_local int BigNumber::scale_ = 0;
+#else
 int BigNumber::scale_ = 0;
+#endif
 
 // constructor
 BigNumber::BigNumber () : num_ (NULL)
@@ -25,6 +29,14 @@ BigNumber::BigNumber (const char * s) : num_ (NULL)
   bc_str2num(&num_, s, scale_);
 } // end of constructor from string
 
+// Read a number from a span of characters, reporting how many were used
+// in consumed (if not NULL).  result is zero if there was no number.
+int BigNumber::parse (const char * s, const size_t length, BigNumber & result,
+                      size_t * consumed, const int flags)
+{
+  return bc_parse_num (&result.num_, s, length, scale_, flags, consumed);
+} // end of BigNumber::parse
+
 BigNumber::BigNumber (const int n) : num_ (NULL)  // constructor from int
 {
   bc_int2num (&num_, n);
@@ -66,6 +78,23 @@ int BigNumber::setScale (const int scale)
   return old_scale;
 }  // end of BigNumber::setScale
 
+// errors in any thread go to the handler
+BigNumber::ErrorHandler BigNumber::setErrorHandler (ErrorHandler handler)
+{
+  return bc_set_error_handler (handler);
+} // end of BigNumber::setErrorHandler
+
+// progress and stopping, for operations in this thread
+void BigNumber::setProgressHandler (ProgressHandler handler, void * context)
+{
+  bc_set_poll_handler (handler, context);
+} // end of BigNumber::setProgressHandler
+
+bool BigNumber::stopped ()
+{
+  return bc_poll_stopped () != 0;
+} // end of BigNumber::stopped
+
 // initialize package
 // supply scale (number of decimal places): default zero
 void BigNumber::begin (const int scale)
@@ -75,9 +104,10 @@ void BigNumber::begin (const int scale)
 } // end of BigNumber::begin
 
 // finished with package
-// free special numbers: zero, one, two
+// free special numbers: zero, one, two, and any constants worked out
 void BigNumber::finish ()
 {
+  freeConstants ();
   bc_free_numbers ();
 } // end of BigNumber::finish
 
@@ -91,18 +121,124 @@ char * BigNumber::toString () const
   return bc_num2str(num_);
 } // end of BigNumber::toString 
 
+// Format the number into buf, which has room for cap characters, without
+// allocating any memory.  scale is the number of decimal places (extra
+// digits are dropped and missing ones are zeros); if it is negative the
+// number's own scale is used.  flags are FORMAT_TRIM_ZEROS to drop zeros
+// (and the decimal point) from the end of the fraction, and FORMAT_PLUS_SIGN
+// or FORMAT_SPACE_SIGN to put a '+' or a space before numbers which are not
+// negative.  A number which shows as zero is never given a '-'.
+// Returns the length of the formatted number.  If that is not less than cap
+// (there has to be room for the terminating 0) nothing is written.
+size_t BigNumber::toChars (char * buf, const size_t cap, const int scale, const int flags) const
+{
+  const char * digits = num_->n_value;
+  const int length = num_->n_len;
+
+  // the decimal places shown, and how many of those are in the number
+  int places = scale < 0 ? num_->n_scale : scale;
+  int stored = places < num_->n_scale ? places : num_->n_scale;
+  if (flags & FORMAT_TRIM_ZEROS)
+    {
+    if (places > stored)
+      places = stored;
+    while (places > 0 && digits [length + places - 1] == 0)
+      places--;
+    stored = places;
+    }
+
+  bool zero = true;
+  for (int i = 0; i < length + stored && zero; i++)
+    zero = digits [i] == 0;
+
+  char sign = 0;
+  if (num_->n_sign == MINUS && !zero)
+    sign = '-';
+  else if (flags & FORMAT_PLUS_SIGN)
+    sign = '+';
+  else if (flags & FORMAT_SPACE_SIGN)
+    sign = ' ';
+
+  const size_t size = (sign ? 1 : 0) + length + (places > 0 ? places + 1 : 0);
+  if (buf == NULL || size >= cap)
+    return size;
+
+  char * p = buf;
+  if (sign)
+    *p++ = sign;
+  for (int i = 0; i < length; i++)
+    *p++ = BCD_CHAR (digits [i]);
+  if (places > 0)
+    {
+    *p++ = '.';
+    for (int i = 0; i < places; i++)
+      *p++ = i < stored ? BCD_CHAR (digits [length + i]) : '0';
+    }
+  *p = 0;
+  return size;
+} // end of BigNumber::toChars
+
+// the length toChars gives (not counting the terminating 0)
+size_t BigNumber::formattedLength (const int scale, const int flags) const
+{
+  return toChars (NULL, 0, scale, flags);
+} // end of BigNumber::formattedLength
+
 BigNumber::operator long () const
 {
   return bc_num2long (num_);
 } // end of BigNumber::operator long
 
+// the size of the pieces that numbers are written out in
+static const size_t WRITE_CHUNK = 32;
+
+// Write the number (as toString would) to sink in pieces of up to
+// WRITE_CHUNK characters, straight from its digits, so no memory is
+// allocated.  Returns the number of characters written, stopping early
+// if the sink takes fewer than it was given.
+size_t BigNumber::writeTo (WriteSink sink, void * context) const
+{
+  char buf [WRITE_CHUNK];
+  size_t used = 0;
+  size_t written = 0;
+
+  if (num_->n_sign == MINUS)
+    buf [used++] = '-';
+
+  const char * digit = num_->n_value;
+  const int count = num_->n_len + num_->n_scale;
+  for (int i = 0; i < count; i++)
+    {
+    // room for a decimal point and a digit
+    if (used + 2 > WRITE_CHUNK)
+      {
+      const size_t len = sink (buf, used, context);
+      written += len;
+      if (len < used)
+        return written;
+      used = 0;
+      }
+    if (i == num_->n_len)
+      buf [used++] = '.';
+    buf [used++] = BCD_CHAR (*digit++);
+    }
+
+  if (used > 0)
+    written += sink (buf, used, context);
+  return written;
+} // end of BigNumber::writeTo
+
+// a WriteSink for printTo
+static size_t printSink (const char * s, const size_t length, void * context)
+{
+  return ((Print *) context)->write ((const uint8_t *) s, length);
+} // end of printSink
+
 // Allow Arduino's Serial.print() to print BigNumber objects!
+// The digits are streamed, so printing needs no memory for a copy of the number.
 size_t BigNumber::printTo(Print& p) const
 {
-  char *buf = bc_num2str(num_);
-  size_t len = p.write(buf);
-  free(buf);
-  return len;
+  return writeTo (printSink, &p);
 }
 
 // add
@@ -231,6 +367,40 @@ BigNumber BigNumber::pow (const BigNumber power) const
   return result;
 } // end of BigNumber::pow
 
+// multiply by 10^places exactly (divide if places is negative)
+BigNumber BigNumber::shiftLeftDigits (const int places) const
+{
+  BigNumber result;
+  bc_shift_num (num_, places, &result.num_);
+  return result;
+} // end of BigNumber::shiftLeftDigits
+
+// divide by 10^places exactly (multiply if places is negative)
+BigNumber BigNumber::shiftRightDigits (const int places) const
+{
+  return shiftLeftDigits (- places);
+} // end of BigNumber::shiftRightDigits
+
+// as * 10^places: the product keeps the scale of the number
+BigNumber BigNumber::mulPow10 (const int places) const
+{
+  if (places < 0)
+    return divPow10 (- places);
+  BigNumber result;
+  bc_shift_scale (num_, places, num_->n_scale, &result.num_);
+  return result;
+} // end of BigNumber::mulPow10
+
+// as / 10^places: the quotient is truncated to the current scale
+BigNumber BigNumber::divPow10 (const int places) const
+{
+  if (places < 0)
+    return mulPow10 (- places);
+  BigNumber result;
+  bc_shift_scale (num_, - places, scale_, &result.num_);
+  return result;
+} // end of BigNumber::divPow10
+
 void BigNumber::divMod (const BigNumber divisor, BigNumber & quotient, BigNumber & remainder) const
 {
   bc_divmod (num_, divisor.num_, &quotient.num_, &remainder.num_, 0);
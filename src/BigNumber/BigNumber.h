@@ -20,11 +20,25 @@ extern "C"
  #include "number.h" 
 }
 
+// Threads (with BIGNUMBER_THREADS, see number.h): call begin once, before
+// starting any other threads, and finish after they are done.  Each thread
+// has its own scale, which starts at zero in threads other than the one
+// which called begin.  Numbers may be copied and shared between threads
+// freely, as a number is never changed once made (assigning to a BigNumber
+// gives it a new one), but a single BigNumber object must not be assigned
+// to by one thread while another uses it.  The cached constants (pi, e and
+// so on) are shared, behind a lock.
+
 class BigNumber : public Printable
 {
   
   // the current scaling amount - shared amongst all BigNumbers
+  // (or those of one thread, with BIGNUMBER_THREADS)
+#if BIGNUMBER_THREADS
+  static thread_local int scale_;
+#else
   static int scale_;
+#endif
 
   // member variable (the big number)
   bc_num        num_;
@@ -34,6 +48,11 @@ public:
   // constructors
   BigNumber ();  // default constructor
   BigNumber (const char * s);   // constructor from string
+  // Read a number from length characters (which need not end in a 0) into
+  // result, to the current scale.  flags can be BC_PARSE_UNDERSCORES and
+  // BC_PARSE_EXPONENT.  Returns BC_PARSE_OK, or an error (see number.h).
+  static int parse (const char * s, const size_t length, BigNumber & result,
+                    size_t * consumed = NULL, const int flags = 0);
   BigNumber (const int n);  // constructor from int
   // copy constructor
   BigNumber (const BigNumber & rhs); 
@@ -45,11 +64,34 @@ public:
   static void begin (const int scale = 0);
   static void finish ();  // free memory used by 'begin' method
   static int setScale (const int scale = 0);
+  // Have handler called on errors (eg. out of memory) and warnings (which
+  // are negative, see number.h), returning the previous handler.  If it
+  // returns from an error, the library stops as it does with no handler.
+  typedef bc_error_handler ErrorHandler;
+  static ErrorHandler setErrorHandler (ErrorHandler handler);
+  // Have handler told how long operations in this thread are getting on
+  // (see bc_poll in number.h).  If it returns nonzero they stop early, and
+  // stopped () is true until a handler is set again: what they return then
+  // means nothing.
+  typedef bc_poll_handler ProgressHandler;
+  static void setProgressHandler (ProgressHandler handler, void * context = NULL);
+  static bool stopped ();
   
   // for outputting purposes ...
   char * toString () const;  // returns number as string, MUST FREE IT after use!
   operator long () const;
+  // floating point: the exact value of d, or the shortest decimal which
+  // converts back to it; and the nearest double to the number
+  static BigNumber fromDouble (const double d, const bool shortest = false);
+  double toDouble () const;
+  // format into a buffer the caller supplies (see BigNumber.cpp)
+  enum { FORMAT_TRIM_ZEROS = 1, FORMAT_PLUS_SIGN = 2, FORMAT_SPACE_SIGN = 4 };
+  size_t formattedLength (const int scale = -1, const int flags = 0) const;
+  size_t toChars (char * buf, const size_t cap, const int scale = -1, const int flags = 0) const;
   virtual size_t printTo(Print& p) const; // for Arduino Serial.print()
+  // write the number to a sink, which returns how many characters it took
+  typedef size_t (* WriteSink) (const char * s, const size_t length, void * context);
+  size_t writeTo (WriteSink sink, void * context) const;
 
   // operators ... assignment
   BigNumber & operator= (const BigNumber & rhs);
@@ -105,12 +147,532 @@ public:
   // other mathematical operations
   BigNumber sqrt () const;
   BigNumber pow (const BigNumber power) const;
+  // Powers of ten, by moving the digits (in time linear in their length).
+  // The shifts are exact (shifting right adds places); mulPow10 and
+  // divPow10 give what * and / by 10^places would at the current scale.
+  BigNumber shiftLeftDigits (const int places) const;
+  BigNumber shiftRightDigits (const int places) const;
+  BigNumber mulPow10 (const int places) const;
+  BigNumber divPow10 (const int places) const;
   // divide number by divisor, give quotient and remainder
   void divMod (const BigNumber divisor, BigNumber & quotient, BigNumber & remainder) const;
   // raise number by power, modulus modulus
   BigNumber powMod (const BigNumber power, const BigNumber & modulus) const;
   
+  // exponential and natural logarithm, to the current scale
+  BigNumber exp () const;  // an error (see setErrorHandler) if too large to hold
+  BigNumber ln () const;  // returns zero if the number is not positive
+
+  // trigonometric functions (in radians), to the current scale
+  BigNumber sin () const;
+  BigNumber cos () const;
+  BigNumber tan () const;
+  BigNumber atan () const;
+  static BigNumber atan2 (const BigNumber & y, const BigNumber & x);  // angle of the point (x, y)
+
+  // constants to scale decimal places (default: the current scale)
+  // The value is kept, so asking again for the same or fewer places is quick.
+  // pi, e and ln2 use every core (with BIGNUMBER_THREADS) for many places.
+  static BigNumber pi (const int scale = -1);
+  static BigNumber e (const int scale = -1);
+  static BigNumber ln2 (const int scale = -1);
+  static BigNumber sqrt2 (const int scale = -1);
+
+  // Sums of series by binary splitting, to scale decimal places (default: the
+  // current scale).  Term n (counting from 0) of the series is
+  //   a (n) / b (n) * p (0) * p (1) * ... * p (n) / (q (0) * q (1) * ... * q (n))
+  // and the callback sets a, b, p and q for term n (they start as 1).  They
+  // must be integers: scale any fractions up into q (or b).
+  // context is passed to the callback unchanged.  If count is zero, terms are
+  // added until they no longer change the sum at the scale.
+  typedef void (* SeriesTerm) (const long n, void * context,
+                               BigNumber & a, BigNumber & b, BigNumber & p, BigNumber & q);
+  typedef void (* SeriesTermLong) (const long n, void * context,
+                                   long & a, long & b, long & p, long & q);
+  static BigNumber seriesSum (SeriesTerm term, void * context, const long count = 0, int scale = -1);
+  static BigNumber seriesSum (SeriesTermLong term, void * context, const long count = 0, int scale = -1);
+
+  // combinatorial functions (exact integers)
+  static BigNumber factorial (const long n);  // zero if n is negative
+  static BigNumber binomial (const long n, long k);  // zero unless 0 <= k <= n
+  static BigNumber primorial (const long n);  // the product of the primes up to n
+
+  // other bases, for the integer part of the number (see BigNumberRadix.cpp)
+  static BigNumber fromBase (const char * s, const int base);  // base 2 to 36, else zero
+  char * toBase (const int base) const;  // MUST FREE IT after use! (NULL unless base 2 to 36)
+  static BigNumber fromHex (const char * s);  // with or without "0x"
+  char * toHex () const;  // MUST FREE IT after use!
+  // unsigned integers as bytes, most significant first if bigEndian
+  static BigNumber fromBytes (const uint8_t * bytes, const size_t length, const bool bigEndian = true);
+  // returns the number of bytes needed, and only writes them if they fit
+  size_t toBytes (uint8_t * bytes, const size_t length, const bool bigEndian = true) const;
+
+  // bitwise operations on the integer part, as a two's complement integer
+  // of unlimited length, so ~n is -n - 1 (see BigNumberBits.cpp)
+  BigNumber operator& (const BigNumber & n) const;
+  BigNumber operator| (const BigNumber & n) const;
+  BigNumber operator^ (const BigNumber & n) const;
+  BigNumber operator~ () const;
+  BigNumber operator<< (const int bits) const;
+  BigNumber operator>> (const int bits) const;  // rounds down
+  BigNumber & operator&= (const BigNumber & n) { return *this = *this & n; }
+  BigNumber & operator|= (const BigNumber & n) { return *this = *this | n; }
+  BigNumber & operator^= (const BigNumber & n) { return *this = *this ^ n; }
+  BigNumber & operator<<= (const int bits) { return *this = *this << bits; }
+  BigNumber & operator>>= (const int bits) { return *this = *this >> bits; }
+  long bitLength () const;  // of the size: zero for zero
+  bool testBit (const int bit) const;
+  long popCount () const;  // of the size
+
+  // compact binary form (see BigNumberSerialize.cpp)
+  size_t serializedSize () const;
+  // returns the size, and only writes the bytes if they fit
+  size_t serialize (uint8_t * buf, const size_t cap) const;
+  // returns the bytes used, or zero if they are not a valid number
+  static size_t deserialize (const uint8_t * buf, const size_t length, BigNumber & result);
+
+  // The same operation on each of count numbers, into out (which may be in),
+  // spread over threads threads (default: one for each core) if built with
+  // BIGNUMBER_THREADS (see BigNumberBatch.cpp).
+  typedef void (* EachFunction) (const BigNumber & in, BigNumber & out, void * context);
+  static void forEach (const BigNumber * in, BigNumber * out, const size_t count,
+                       EachFunction function, void * context, const int threads = 0);
+  static void mulEach (const BigNumber * in, BigNumber * out, const size_t count,
+                       const BigNumber & factor, const int threads = 0);
+  static void powModEach (const BigNumber * in, BigNumber * out, const size_t count,
+                          const BigNumber & power, const BigNumber & modulus, const int threads = 0);
+  static void sqrtEach (const BigNumber * in, BigNumber * out, const size_t count,
+                        const int threads = 0);
+  // The sum or product of count numbers, as a balanced tree, optionally in
+  // threads threads (zero for one for each core).
+  static BigNumber sum (const BigNumber * numbers, const size_t count, const int threads = 1);
+  static BigNumber product (const BigNumber * numbers, const size_t count, const int threads = 1);
+
+private:
+
+  friend class BigNumberView;
+  friend class BigNumberTable;
+  friend class BigNumberTask;
+  friend class BigNumberJob;
+  friend class BigReal;
+  friend class BigBall;
+  friend class BigFloat;
+
+  // helpers for the mathematical functions (see BigNumberMath.cpp)
+  enum SeriesKind { EXP_SERIES, SIN_SERIES, COS_SERIES };
+  static long seriesDenominator (const SeriesKind kind, const long n);
+  static int decimalExponent (const bc_num num);
+  static double log10Magnitude (const bc_num num);
+  static BigNumber shift (const BigNumber & n, const int places);
+  static BigNumber truncate (const BigNumber & n, const int scale);
+  static BigNumber piece (const BigNumber & x, const int start, const int end);
+  static BigNumber fromLong (const long n);
+  static BigNumber guess (const double value);
+  static void splitSeries (SeriesTerm term, void * context, const int places,
+                           const long a, const long b, const long total,
+                           BigNumber & P, BigNumber & Q, BigNumber & B, BigNumber & T,
+                           const int threads = 1);
+  static void splitWork (void * context);
+  static BigNumber sumSeries (SeriesTerm term, void * context, const int places,
+                              long count, const int scale, const int threads = 1);
+  static void longSeriesTerm (const long n, void * context,
+                              BigNumber & a, BigNumber & b, BigNumber & p, BigNumber & q);
+  static void chunkTerm (const long n, void * context,
+                         BigNumber & a, BigNumber & b, BigNumber & p, BigNumber & q);
+  static BigNumber seriesChunk (const BigNumber & p, const int places, const SeriesKind kind,
+                                const int scale, const int threads = 1);
+  static BigNumber expPositive (const BigNumber & x, const int scale);
+  static BigNumber lnNewton (const BigNumber & x, const int scale);
+  static void atanTerm (const long n, void * context,
+                        BigNumber & a, BigNumber & b, BigNumber & p, BigNumber & q);
+  static BigNumber atanInverse (const int k, const bool hyperbolic, const int scale,
+                                const int threads = 1);
+  static void sinCosReduced (const BigNumber & x, const int scale, BigNumber & s, BigNumber & c);
+  static void sinCos (const BigNumber & x, const int scale, BigNumber & s, BigNumber & c);
+  static BigNumber atanWork (const BigNumber & x, const int scale);
+  static BigNumber cached (bc_num & cache, int & cacheScale, int scale,
+                           BigNumber (* compute) (const int scale));
+  static void freeConstants ();
+  static BigNumber inverseSqrt (const int n, const int scale);
+  static void piTerm (const long n, void * context,
+                      BigNumber & a, BigNumber & b, BigNumber & p, BigNumber & q);
+  static BigNumber piChudnovsky (const int scale);
+  static BigNumber eSeries (const int scale);
+  static BigNumber ln2Series (const int scale);
+  static BigNumber sqrt2Newton (const int scale);
+  static BigNumber ln10Newton (const int scale);
+
+  // helpers for the combinatorial functions (see BigNumberCombinatorics.cpp)
+  enum PrimeProduct { SWING_PRIMES, BINOMIAL_PRIMES, ALL_PRIMES };
+  static int primePower (const PrimeProduct kind, const long p, const long n, const long k);
+  static BigNumber primeProduct (const unsigned char * sieve, const PrimeProduct kind,
+                                 const long n, const long k, const long low, const long high);
+  static BigNumber factorialSwing (const unsigned char * sieve, const long n);
+
+  // helpers for floating point (see BigNumberDouble.cpp)
+  static BigNumber powerOfTwo (const int n);
+  static BigNumber exactDouble (const double d);
+
+  // helpers for threads, sums and products (see BigNumberBatch.cpp)
+  static int threadCount (int threads, const size_t count);
+  static void runThreads (void (* work) (void * context), void * context, const int threads);
+  static void runPair (void (* first) (void * context), void * firstContext,
+                       void (* second) (void * context), void * secondContext);
+  static void reduceWork (void * context);
+  static BigNumber reduce (const BigNumber * numbers, const size_t count,
+                           const bool multiply, const int threads);
+
+  // helpers for other bases (see BigNumberRadix.cpp)
+  struct RadixPowers;
+  static const BigNumber & radixPower (RadixPowers & powers, const int level);
+  static BigNumber reciprocal (const BigNumber & n);
+  static void radixOut (const BigNumber & n, unsigned char * digits, const size_t count,
+                        RadixPowers & powers);
+  static BigNumber radixIn (const unsigned char * digits, const size_t count, RadixPowers & powers);
+  size_t radixDigits (const int base, unsigned char * & digits) const;
+
+  // helpers for bitwise operations (see BigNumberBits.cpp)
+  uint8_t * twosComplement (const size_t length) const;
+  static BigNumber fromTwosComplement (uint8_t * bytes, const size_t length);
+  static BigNumber bitwise (const BigNumber & a, const BigNumber & b, const char op);
+
 };  // end class declaration
 
+// A number using digits held somewhere else, such as in a BigNumberTable,
+// without copying them.  The digits must stay there while the view, or any
+// BigNumber copied from it, is in use.  Making a view allocates one small
+// descriptor for the number (not its digits); copies of the view, and
+// BigNumbers copied from it, share that.
+class BigNumberView
+{
+  // its own number, whose digits are never freed
+  BigNumber number_;
+
+  void set (const char * digits, const int length, const int scale, const bool negative);
+
+public:
+  BigNumberView (const char * digits, const int length, const int scale, const bool negative);
+
+  operator const BigNumber & () const { return number_; }
+  const BigNumber & number () const { return number_; }
+};  // end of class BigNumberView
+
+// A table of numbers in the binary form of BigNumberTable::write, which can
+// be read where it is (eg. in a memory-mapped file or flash).  The numbers
+// are views of the digits in the table, so the digits are neither parsed
+// nor copied, though each number read allocates a descriptor (see
+// BigNumberView).
+class BigNumberTable
+{
+  const uint8_t * data_;
+  size_t count_;
+
+public:
+  BigNumberTable () : data_ (NULL), count_ (0) { }
+
+  // the size of a table of count numbers, and writing it (if it fits in cap)
+  static size_t size (const BigNumber * numbers, const size_t count);
+  static size_t write (const BigNumber * numbers, const size_t count, uint8_t * buf, const size_t cap);
+
+  // use a table, which must stay where it is; returns false if it is not valid
+  bool open (const uint8_t * data, const size_t length);
+  size_t count () const { return count_; }
+  BigNumberView operator[] (const size_t i) const;
+};  // end of class BigNumberTable
+
+// A computation done in a thread of its own (with BIGNUMBER_THREADS, see
+// BigNumberTask.cpp), which can be waited for, watched and cancelled.
+// Without threads it is done by start, and can only be stopped by the
+// progress handler.
+class BigNumberTask
+{
+public:
+  typedef BigNumber (* Function) (void * context);
+
+  BigNumberTask ();
+  ~BigNumberTask ();  // cancels the computation, and waits for it to stop
+
+  // Have handler told how the computations started after this are getting
+  // on, from their thread; if it returns nonzero the computation stops (as
+  // with cancel).
+  void setProgressHandler (BigNumber::ProgressHandler handler, void * context = NULL);
+
+  // Start working out function (context), or one of the operations, at the
+  // current scale.  Returns false if a computation is still going.
+  bool start (Function function, void * context);
+  bool sqrt (const BigNumber & x);
+  bool pow (const BigNumber & x, const BigNumber & power);
+  bool powMod (const BigNumber & x, const BigNumber & power, const BigNumber & modulus);
+  bool divide (const BigNumber & x, const BigNumber & y);
+  bool pi (const int scale = -1);
+  bool e (const int scale = -1);
+
+  void cancel ();
+  bool finished () const;
+  bool cancelled () const;  // true if it stopped before finishing
+  bool wait (const unsigned long ms);  // true if it finished within ms
+  BigNumber result ();  // waits for it to finish; zero if it was cancelled
+  // the latest progress reported: done out of total (zero if not known)
+  void progress (long & done, long & total) const;
+
+private:
+  struct State;
+  State * state_;
+
+  BigNumberTask (const BigNumberTask &);  // not copyable
+  BigNumberTask & operator= (const BigNumberTask &);
+};  // end of class BigNumberTask
+
+// An operation done a little at a time (see BigNumberJob.cpp), for a loop
+// which cannot wait for all of it at once.  Each step does about budget
+// digit operations (single digit multiplies and adds, at least one digit of
+// a division) and returns true once the result is ready.  The scale is the
+// one current when the job is made.
+class BigNumberJob
+{
+public:
+  virtual ~BigNumberJob () { }
+
+  bool step (const long budget);
+  bool stepFor (const unsigned long us);  // steps for about us microseconds
+  bool finished () const { return finished_; }
+  const BigNumber & result () const { return result_; }  // once finished
+
+protected:
+  BigNumberJob () : finished_ (false) { }
+  virtual bool work (long & budget) = 0;  // true when result_ is ready
+
+  // for the jobs, which work with the numbers directly
+  static int currentScale () { return BigNumber::scale_; }
+  static bc_num & num (BigNumber & n) { return n.num_; }
+  static bc_num num (const BigNumber & n) { return n.num_; }
+  static long multiplyCost (const bc_num n1, const bc_num n2);
+
+  BigNumber result_;
+
+private:
+  bool finished_;
+
+  BigNumberJob (const BigNumberJob &);  // not copyable
+  BigNumberJob & operator= (const BigNumberJob &);
+};  // end of class BigNumberJob
+
+// x / y to the current scale (zero if y is zero)
+class BigNumberDivideJob : public BigNumberJob
+{
+  bc_divide_state state_;
+  bool dividing_;
+
+public:
+  BigNumberDivideJob (const BigNumber & x, const BigNumber & y);
+  ~BigNumberDivideJob ();
+
+protected:
+  bool work (long & budget);
+};  // end of class BigNumberDivideJob
+
+// x ^ power mod modulus, as x.powMod (power, modulus) (zero if modulus is
+// zero or power is negative)
+class BigNumberPowModJob : public BigNumberJob
+{
+  enum Stage { HALVE, REDUCE_RESULT, REDUCE_POWER };
+
+  BigNumber power_, exponent_, modulus_, dividend_;
+  bc_divide_state state_;
+  Stage stage_;
+  int scale_;
+  int rscale_;
+
+  void startModulo (const BigNumber & n);
+  BigNumber finishModulo ();
+
+public:
+  BigNumberPowModJob (const BigNumber & x, const BigNumber & power, const BigNumber & modulus);
+  ~BigNumberPowModJob ();
+
+protected:
+  bool work (long & budget);
+};  // end of class BigNumberPowModJob
+
+// the square root of x, as x.sqrt () (zero if x is negative)
+class BigNumberSqrtJob : public BigNumberJob
+{
+  BigNumber x_, guess_, previous_;
+  bc_divide_state state_;
+  bool dividing_;
+  int cscale_;
+  int rscale_;
+
+public:
+  BigNumberSqrtJob (const BigNumber & x);
+  ~BigNumberSqrtJob ();
+
+protected:
+  bool work (long & budget);
+};  // end of class BigNumberSqrtJob
+
+// An exact real number (see BigNumberReal.cpp): the operations are only
+// recorded, and worked out when a value is asked for, each to just the
+// places needed for that value to be right.  Errors (eg. dividing by zero)
+// give zero, as for BigNumber.  A BigReal and the BigReals made from it
+// must all be used in the same thread.
+class BigReal
+{
+  struct Node;
+  Node * node_;
+
+  explicit BigReal (Node * node);
+  static void release (Node * node);
+  static BigReal make (const int op, const BigReal * x, const BigReal * y);
+  static int magnitude (Node * node);
+  static bool lowerBound (Node * node, const int places, int & n, bool & negative);
+  static BigNumber approximate (Node * node, const int places);
+
+public:
+  BigReal ();  // zero
+  BigReal (const BigNumber & n);
+  BigReal (const int n);
+  BigReal (const char * s);  // all the digits of s, whatever the scale
+  BigReal (const BigReal & rhs);
+  BigReal & operator= (const BigReal & rhs);
+  ~BigReal ();
+
+  BigReal operator- () const;
+  BigReal operator+ (const BigReal & rhs) const;
+  BigReal operator- (const BigReal & rhs) const;
+  BigReal operator* (const BigReal & rhs) const;
+  BigReal operator/ (const BigReal & rhs) const;
+  BigReal & operator+= (const BigReal & rhs) { return *this = *this + rhs; }
+  BigReal & operator-= (const BigReal & rhs) { return *this = *this - rhs; }
+  BigReal & operator*= (const BigReal & rhs) { return *this = *this * rhs; }
+  BigReal & operator/= (const BigReal & rhs) { return *this = *this / rhs; }
+
+  BigReal sqrt () const;
+  BigReal pow (const long n) const;
+  BigReal exp () const;
+  BigReal ln () const;
+  BigReal sin () const;
+  BigReal cos () const;
+  BigReal atan () const;
+  static BigReal pi ();
+  static BigReal e ();
+
+  // the value truncated to places decimal places, less than two units in
+  // the last place from the exact value
+  BigNumber value (const int places) const;
+};  // end of class BigReal
+
+// A number with a bound on its error (see BigNumberBall.cpp): a midpoint,
+// worked out at the current scale, and a radius which the true value is
+// guaranteed to be within.  An operation with no bounded result (eg.
+// dividing by a ball which may be zero) gives zero with an infinite radius.
+class BigBall
+{
+  BigNumber mid_;
+  double radius_;
+
+  static double leadingDigits (const bc_num num, int & power);
+  static double upper (const BigNumber & n);
+  static double lower (const BigNumber & n);
+  static double unit (const int places);
+  static double rounding (const BigNumber & result, const int exact);
+  static BigBall unbounded ();
+
+public:
+  BigBall ();  // zero
+  BigBall (const BigNumber & midpoint, const double radius = 0);
+  BigBall (const int n);
+  BigBall (const char * s);  // all the digits of s, whatever the scale
+
+  const BigNumber & midpoint () const { return mid_; }
+  double radius () const { return radius_; }
+  bool bounded () const;
+  bool accurate (const int places) const;
+
+  BigBall operator- () const;
+  BigBall operator+ (const BigBall & rhs) const;
+  BigBall operator- (const BigBall & rhs) const;
+  BigBall operator* (const BigBall & rhs) const;
+  BigBall operator/ (const BigBall & rhs) const;
+  BigBall & operator+= (const BigBall & rhs) { return *this = *this + rhs; }
+  BigBall & operator-= (const BigBall & rhs) { return *this = *this - rhs; }
+  BigBall & operator*= (const BigBall & rhs) { return *this = *this * rhs; }
+  BigBall & operator/= (const BigBall & rhs) { return *this = *this / rhs; }
+
+  BigBall sqrt () const;
+  BigBall pow (const long n) const;
+
+  // Work out function (context) to places correct places, at the lowest
+  // scale (up to maxScale) which makes the radius small enough.
+  typedef BigBall (* Function) (void * context);
+  static bool certify (Function function, void * context, const int places,
+                       BigNumber & result, const int maxScale = 1000);
+};  // end of class BigBall
+
+// A decimal floating point number (see BigNumberFloat.cpp): an integer
+// mantissa times a power of ten, so very large and very small numbers
+// need no more digits than their significant ones.  Results are truncated
+// to setDigits significant digits, which is per thread like the scale.
+// Dividing by zero, or the square root of a negative number, gives zero.
+class BigFloat : public Printable
+{
+  // the precision, in significant digits
+#if BIGNUMBER_THREADS
+  static thread_local int digits_;
+#else
+  static int digits_;
+#endif
+
+  // an integer with no zeros at the end (except for zero itself)
+  BigNumber mantissa_;
+  long exponent_;
+
+  static int length (const BigNumber & n);
+  static BigNumber dropDigits (const BigNumber & n, const long count);
+  static BigNumber addZeros (const BigNumber & n, const long count);
+  static BigNumber negate (const BigNumber & n);
+  static long top (const BigFloat & x);
+  static BigFloat sum (const BigFloat & a, const BigFloat & b, const bool subtract);
+  void normalize ();
+
+public:
+  BigFloat ();  // zero
+  BigFloat (const int n);
+  explicit BigFloat (const BigNumber & n);
+  BigFloat (const BigNumber & mantissa, const long exponent);
+  BigFloat (const char * s);  // eg. "-1.25e-300"
+
+  // the significant digits of results (at least one): returns the old one
+  static int setDigits (const int digits = 20);
+
+  const BigNumber & mantissa () const { return mantissa_; }
+  long exponent () const { return exponent_; }
+  BigNumber toBigNumber () const;  // exact
+  char * toString () const;  // MUST FREE IT after use!
+  virtual size_t printTo (Print & p) const;
+  bool isZero () const;
+  bool isNegative () const;
+
+  BigFloat operator- () const;
+  BigFloat operator+ (const BigFloat & rhs) const;
+  BigFloat operator- (const BigFloat & rhs) const;
+  BigFloat operator* (const BigFloat & rhs) const;
+  BigFloat operator/ (const BigFloat & rhs) const;
+  BigFloat & operator+= (const BigFloat & rhs) { return *this = *this + rhs; }
+  BigFloat & operator-= (const BigFloat & rhs) { return *this = *this - rhs; }
+  BigFloat & operator*= (const BigFloat & rhs) { return *this = *this * rhs; }
+  BigFloat & operator/= (const BigFloat & rhs) { return *this = *this / rhs; }
+  BigFloat sqrt () const;
+
+  // -1, 0 or 1 as a is below, equal to or above b
+  static int compare (const BigFloat & a, const BigFloat & b);
+  bool operator== (const BigFloat & rhs) const { return compare (*this, rhs) == 0; }
+  bool operator!= (const BigFloat & rhs) const { return compare (*this, rhs) != 0; }
+  bool operator<  (const BigFloat & rhs) const { return compare (*this, rhs) < 0; }
+  bool operator<= (const BigFloat & rhs) const { return compare (*this, rhs) <= 0; }
+  bool operator>  (const BigFloat & rhs) const { return compare (*this, rhs) > 0; }
+  bool operator>= (const BigFloat & rhs) const { return compare (*this, rhs) >= 0; }
+};  // end of class BigFloat
+
 
 #endif
@@ -0,0 +1,281 @@
+//
+//  BigNumberBall.cpp
+//
+//  Numbers with a guaranteed bound on their error.
+//  Released into the public domain.
+//
+//  A BigBall is a BigNumber midpoint and a double radius: the true value is
+//  somewhere within radius of the midpoint.  The midpoint is worked out at
+//  the current scale like any BigNumber, and the radius grows by the error
+//  carried over from the operands plus the error of truncating the
+//  midpoint to the scale.  The radius is always rounded up (the few units
+//  in the last place of a double are allowed for on every operation), so it
+//  is a true bound, not an estimate.
+//
+//  That makes it possible to work at a small scale and find out afterwards
+//  whether it was enough: certify runs a calculation at a few more places
+//  than wanted, and again with more places (worked out from how much the
+//  radius missed by) only if the radius shows that it was not.
+//
+//  As the radius is a double, balls are for up to about 300 places.
+
+#include "BigNumber.h"
+
+#include <float.h>
+#include <limits.h>
+
+// the extra places certify works to, above the places wanted
+static const int GUARD_PLACES = 5;
+
+// factor allowing for the rounding of a few double operations
+static const double UP = 1 + 8 * DBL_EPSILON;
+static const double DOWN = 1 - 8 * DBL_EPSILON;
+
+// the smallest positive double, added so that an underflow cannot round a
+// bound down to zero
+static const double TINY = DBL_MIN * DBL_EPSILON;
+
+// bounds for a + b, a * b and a / b, for a, b >= 0
+static double addUp (const double a, const double b)
+{
+  return (a + b) * UP;
+} // end of addUp
+
+static double mulUp (const double a, const double b)
+{
+  if (a == 0 || b == 0)
+    return 0;
+  return a * b * UP + TINY;
+} // end of mulUp
+
+static double divUp (const double a, const double b)
+{
+  if (a == 0)
+    return 0;
+  return a / b * UP + TINY;
+} // end of divUp
+
+static double sqrtUp (const double a)
+{
+  if (a == 0)
+    return 0;
+  return ::sqrt (a) * UP + TINY;
+} // end of sqrtUp
+
+// ------------------------------- BOUNDS ---------------------------------
+
+// the leading (up to 15) digits of a non-zero number, as an integer, and
+// the power of ten of the last of them
+double BigBall::leadingDigits (const bc_num num, int & power)
+{
+  const int exponent = BigNumber::decimalExponent (num);
+  const char * digit = num->n_value + num->n_len - 1 - exponent;
+  const char * end = num->n_value + num->n_len + num->n_scale;
+  double digits = 0;
+  int count = 0;
+  for ( ; count < 15 && digit < end; count++)
+    digits = digits * 10 + *digit++;
+  power = exponent - count + 1;
+  return digits;
+} // end of BigBall::leadingDigits
+
+// at least |n|
+double BigBall::upper (const BigNumber & n)
+{
+  if (n.isZero ())
+    return 0;
+  int power;
+  const double digits = leadingDigits (n.num_, power);
+  if (power + 16 < DBL_MIN_10_EXP)
+    return DBL_MIN;  // too small for the digits to be kept
+  return (digits + 1) * ::pow (10.0, power) * UP + TINY;
+} // end of BigBall::upper
+
+// at most |n|
+double BigBall::lower (const BigNumber & n)
+{
+  if (n.isZero ())
+    return 0;
+  int power;
+  const double digits = leadingDigits (n.num_, power);
+  if (power + 16 < DBL_MIN_10_EXP)
+    return 0;
+  return digits * ::pow (10.0, power) * DOWN;
+} // end of BigBall::lower
+
+// at least 10^-places
+double BigBall::unit (const int places)
+{
+  return ::pow (10.0, - places) * UP + TINY;
+} // end of BigBall::unit
+
+// the error of truncating an exact result of scale exact to result
+double BigBall::rounding (const BigNumber & result, const int exact)
+{
+  const int scale = result.num_->n_scale;
+  return scale < exact ? unit (scale) : 0;
+} // end of BigBall::rounding
+
+// what an operation gives if it has no bounded result
+BigBall BigBall::unbounded ()
+{
+  return BigBall (BigNumber (0), HUGE_VAL);
+} // end of BigBall::unbounded
+
+// ---------------------------- CONSTRUCTORS ------------------------------
+
+BigBall::BigBall () : radius_ (0)
+{
+} // end of BigBall::BigBall
+
+BigBall::BigBall (const BigNumber & midpoint, const double radius)
+  : mid_ (midpoint), radius_ (radius >= 0 ? radius : radius < 0 ? - radius : HUGE_VAL)
+{
+} // end of BigBall::BigBall
+
+BigBall::BigBall (const int n) : mid_ (n), radius_ (0)
+{
+} // end of BigBall::BigBall
+
+// all the digits of s, whatever the current scale
+BigBall::BigBall (const char * s) : radius_ (0)
+{
+  const int oldScale = BigNumber::setScale (strlen (s));
+  mid_ = BigNumber (s);
+  BigNumber::setScale (oldScale);
+} // end of BigBall::BigBall
+
+bool BigBall::bounded () const
+{
+  return radius_ < HUGE_VAL;
+} // end of BigBall::bounded
+
+// is the true value within 10^-places of the midpoint?
+bool BigBall::accurate (const int places) const
+{
+  return radius_ <= ::pow (10.0, - places) * DOWN;
+} // end of BigBall::accurate
+
+// ------------------------------ OPERATIONS ------------------------------
+
+BigBall BigBall::operator- () const
+{
+  return BigBall (BigNumber (0) - mid_, radius_);
+} // end of BigBall::operator-
+
+// sums are exact, so only the radii add up
+BigBall BigBall::operator+ (const BigBall & rhs) const
+{
+  return BigBall (mid_ + rhs.mid_, addUp (radius_, rhs.radius_));
+} // end of BigBall::operator+
+
+BigBall BigBall::operator- (const BigBall & rhs) const
+{
+  return BigBall (mid_ - rhs.mid_, addUp (radius_, rhs.radius_));
+} // end of BigBall::operator-
+
+// |ab - a'b'| <= |a'| rb + |b'| ra + ra rb
+BigBall BigBall::operator* (const BigBall & rhs) const
+{
+  const BigNumber product = mid_ * rhs.mid_;
+  double radius = addUp (mulUp (upper (mid_), rhs.radius_), mulUp (upper (rhs.mid_), radius_));
+  radius = addUp (radius, mulUp (radius_, rhs.radius_));
+  radius = addUp (radius, rounding (product, mid_.num_->n_scale + rhs.mid_.num_->n_scale));
+  return BigBall (product, radius);
+} // end of BigBall::operator*
+
+// |a/b - a'/b'| <= (ra + |a'/b'| rb) / |b|, where |b| >= |b'| - rb, which
+// must be above zero
+BigBall BigBall::operator/ (const BigBall & rhs) const
+{
+  const double divisor = (lower (rhs.mid_) - rhs.radius_) * DOWN;
+  if (!(divisor > 0))
+    return unbounded ();
+
+  const BigNumber quotient = mid_ / rhs.mid_;
+  const double ratio = divUp (upper (mid_), lower (rhs.mid_));
+  double radius = divUp (addUp (radius_, mulUp (ratio, rhs.radius_)), divisor);
+  radius = addUp (radius, rounding (quotient, INT_MAX));
+  return BigBall (quotient, radius);
+} // end of BigBall::operator/
+
+// The square root of the part of the ball at or above zero:
+// |sqrt a - sqrt a'| <= ra / sqrt a', and also <= sqrt ra.  A ball
+// wholly below zero has no square root.
+BigBall BigBall::sqrt () const
+{
+  if (!bounded ())
+    return unbounded ();
+  if (mid_.isNegative () || mid_.isZero ())
+    {
+    if (mid_.isNegative () && lower (mid_) > radius_)
+      return unbounded ();
+    return BigBall (BigNumber (0), sqrtUp (radius_));
+    }
+
+  // bc_sqrt stops within a unit of its last (extra) place, then truncates
+  const BigNumber root = mid_.sqrt ();
+  const double low = ::sqrt (lower (mid_)) * DOWN;
+  double radius = sqrtUp (radius_);
+  if (low > 0 && divUp (radius_, low) < radius)
+    radius = divUp (radius_, low);
+  radius = addUp (radius, 2 * rounding (root, INT_MAX));
+  return BigBall (root, radius);
+} // end of BigBall::sqrt
+
+// by squaring and multiplying, so each step bounds its own error
+BigBall BigBall::pow (const long n) const
+{
+  if (n < 0)
+    return BigBall (1) / pow (- n);
+
+  BigBall result (1);
+  BigBall power = *this;
+  for (long bits = n; bits > 0; bits >>= 1)
+    {
+    if (bits & 1)
+      result = result * power;
+    if (bits > 1)
+      power = power * power;
+    }
+  return result;
+} // end of BigBall::pow
+
+// ------------------------------ CERTIFYING ------------------------------
+
+// Work out function (context) to places correct places: run it at a scale
+// a little above places, and while the radius of the result is too big,
+// run it again at a scale raised by the places the radius missed by, up to
+// maxScale.  result is the midpoint truncated to places, less than two
+// units in the last place from the true value.  Returns false (leaving
+// result alone) if maxScale was not enough.
+bool BigBall::certify (Function function, void * context, const int places,
+                       BigNumber & result, const int maxScale)
+{
+  const int oldScale = BigNumber::scale_;
+  int scale = places + GUARD_PLACES;
+  bool done = false;
+  for (;;)
+    {
+    BigNumber::setScale (scale);
+    const BigBall ball = function (context);
+    if (ball.accurate (places))
+      {
+      result = BigNumber::truncate (ball.mid_, places);
+      done = true;
+      break;
+      }
+    if (scale >= maxScale)
+      break;
+
+    // the radius should shrink by ten for each place added
+    int next = scale * 2;
+    if (ball.bounded () && ball.radius_ > 0)
+      next = scale + (int) ceil (log10 (ball.radius_)) + places + GUARD_PLACES;
+    if (next < scale + GUARD_PLACES)
+      next = scale + GUARD_PLACES;
+    scale = next < maxScale ? next : maxScale;
+    }
+  BigNumber::setScale (oldScale);
+  return done;
+} // end of BigBall::certify
@@ -0,0 +1,273 @@
+//
+//  BigNumberBatch.cpp
+//
+//  The same operation on each of an array of BigNumbers, and the sum or
+//  product of an array, spread over threads.
+//  Released into the public domain.
+//
+//  The array is cut into chunks, and each thread takes the next chunk from
+//  a shared counter until there are none left, so a thread which gets the
+//  quick numbers simply does more of them.  The threads all use the scale
+//  of the thread which started them.  Without BIGNUMBER_THREADS (see
+//  number.h) everything is done in the calling thread.
+//
+//  Sums and products are worked out as balanced trees: each half of the
+//  array is reduced, then the two halves are combined, so the big
+//  multiplies are between numbers of about the same size (where Karatsuba
+//  helps most) rather than of a huge total by one more small number.  The
+//  halves near the top of the tree can go to different threads.
+
+#include "BigNumber.h"
+
+#if BIGNUMBER_THREADS
+ #include <atomic>
+ #include <thread>
+ #include <vector>
+typedef std::atomic<size_t> ChunkCounter;
+#else
+typedef size_t ChunkCounter;
+#endif
+
+// chunks for each thread, so that threads which finish early can take more
+static const size_t CHUNKS_PER_THREAD = 8;
+
+// what the threads of a batch share
+struct Batch
+{
+  const BigNumber * in;
+  BigNumber * out;
+  size_t count;
+  size_t chunk;
+  BigNumber::EachFunction function;
+  void * context;
+  ChunkCounter next;  // the next chunk to do
+};
+
+struct PowModContext
+{
+  const BigNumber * power;
+  const BigNumber * modulus;
+};
+
+// one half of a sum or product
+struct Reduction
+{
+  const BigNumber * numbers;
+  size_t count;
+  bool multiply;
+  int threads;
+  BigNumber result;
+};
+
+// the number of threads to use for count pieces of work: threads, or if
+// that is zero, one for each core (and always one without threads)
+int BigNumber::threadCount (int threads, const size_t count)
+{
+#if BIGNUMBER_THREADS
+  if (threads <= 0)
+    threads = std::thread::hardware_concurrency ();
+  if (threads <= 0)
+    threads = 1;
+#else
+  threads = 1;
+#endif
+  if ((size_t) threads > count)
+    threads = count > 0 ? (int) count : 1;
+  return threads;
+} // end of BigNumber::threadCount
+
+// Call work (context) in threads threads, one of them this one, and wait
+// for them all to finish.  They all start with this thread's scale.
+void BigNumber::runThreads (void (* work) (void * context), void * context, const int threads)
+{
+#if BIGNUMBER_THREADS
+  const int scale = scale_;
+  std::vector <std::thread> others;
+  for (int i = 1; i < threads; i++)
+    others.push_back (std::thread ([=] { setScale (scale); work (context); }));
+  work (context);
+  for (size_t i = 0; i < others.size (); i++)
+    others [i].join ();
+#else
+  (void) threads;
+  work (context);
+#endif
+} // end of BigNumber::runThreads
+
+// Call first (firstContext) in another thread and second (secondContext)
+// in this one, and wait for both to finish.
+void BigNumber::runPair (void (* first) (void * context), void * firstContext,
+                         void (* second) (void * context), void * secondContext)
+{
+#if BIGNUMBER_THREADS
+  const int scale = scale_;
+  std::thread other ([=] { setScale (scale); first (firstContext); });
+  second (secondContext);
+  other.join ();
+#else
+  first (firstContext);
+  second (secondContext);
+#endif
+} // end of BigNumber::runPair
+
+// take chunks of the batch until there are none left
+static void batchWork (void * context)
+{
+  Batch & batch = * (Batch *) context;
+  for (;;)
+    {
+    const size_t start = batch.next++ * batch.chunk;
+    if (start >= batch.count)
+      break;
+    const size_t end = batch.count - start > batch.chunk ? start + batch.chunk : batch.count;
+    for (size_t i = start; i < end; i++)
+      batch.function (batch.in [i], batch.out [i], batch.context);
+    }
+} // end of batchWork
+
+// out [i] = the result of function for in [i], for each of count numbers
+// out may be in.  context is passed to function unchanged, and function
+// may be called from several threads at once.
+void BigNumber::forEach (const BigNumber * in, BigNumber * out, const size_t count,
+                         EachFunction function, void * context, const int threads)
+{
+  const int used = threadCount (threads, count);
+  size_t chunk = count / (used * CHUNKS_PER_THREAD);
+  if (chunk == 0)
+    chunk = 1;
+
+  Batch batch;
+  batch.in = in;
+  batch.out = out;
+  batch.count = count;
+  batch.chunk = chunk;
+  batch.function = function;
+  batch.context = context;
+  batch.next = 0;
+  runThreads (batchWork, &batch, used);
+} // end of BigNumber::forEach
+
+static void mulOne (const BigNumber & in, BigNumber & out, void * context)
+{
+  out = in * * (const BigNumber *) context;
+} // end of mulOne
+
+static void powModOne (const BigNumber & in, BigNumber & out, void * context)
+{
+  const PowModContext & p = * (const PowModContext *) context;
+  out = in.powMod (*p.power, *p.modulus);
+} // end of powModOne
+
+static void sqrtOne (const BigNumber & in, BigNumber & out, void * /* context */)
+{
+  out = in.sqrt ();
+} // end of sqrtOne
+
+// out [i] = in [i] * factor
+void BigNumber::mulEach (const BigNumber * in, BigNumber * out, const size_t count,
+                         const BigNumber & factor, const int threads)
+{
+  forEach (in, out, count, mulOne, (void *) &factor, threads);
+} // end of BigNumber::mulEach
+
+// out [i] = in [i] ^ power mod modulus
+void BigNumber::powModEach (const BigNumber * in, BigNumber * out, const size_t count,
+                            const BigNumber & power, const BigNumber & modulus, const int threads)
+{
+  PowModContext context;
+  context.power = &power;
+  context.modulus = &modulus;
+  forEach (in, out, count, powModOne, &context, threads);
+} // end of BigNumber::powModEach
+
+// out [i] = the square root of in [i], to the current scale
+void BigNumber::sqrtEach (const BigNumber * in, BigNumber * out, const size_t count,
+                          const int threads)
+{
+  forEach (in, out, count, sqrtOne, NULL, threads);
+} // end of BigNumber::sqrtEach
+
+// ------------------------------ REDUCTIONS ------------------------------
+
+void BigNumber::reduceWork (void * context)
+{
+  Reduction & r = * (Reduction *) context;
+  r.result = reduce (r.numbers, r.count, r.multiply, r.threads);
+} // end of BigNumber::reduceWork
+
+// The exact sum or product of count (at least one) numbers, as a tree,
+// splitting it between threads threads.
+BigNumber BigNumber::reduce (const BigNumber * numbers, const size_t count,
+                             const bool multiply, const int threads)
+{
+  if (count == 1)
+    return numbers [0];
+
+  const size_t half = count / 2;
+  BigNumber left, right;
+  if (threads > 1)
+    {
+    Reduction a, b;
+    a.numbers = numbers;
+    a.count = half;
+    a.multiply = multiply;
+    a.threads = threads / 2;
+    b.numbers = numbers + half;
+    b.count = count - half;
+    b.multiply = multiply;
+    b.threads = threads - threads / 2;
+    runPair (reduceWork, &a, reduceWork, &b);
+    left = a.result;
+    right = b.result;
+    }
+  else
+    {
+    left = reduce (numbers, half, multiply, 1);
+    right = reduce (numbers + half, count - half, multiply, 1);
+    }
+
+  BigNumber result;
+  if (multiply)
+    bc_multiply (left.num_, right.num_, &result.num_, left.num_->n_scale + right.num_->n_scale);
+  else
+    bc_add (left.num_, right.num_, &result.num_, 0);
+  return result;
+} // end of BigNumber::reduce
+
+// The sum of count numbers (zero if there are none), with the scale
+// operator+ would give it.
+BigNumber BigNumber::sum (const BigNumber * numbers, const size_t count, const int threads)
+{
+  if (count == 0)
+    return BigNumber (0);
+
+  BigNumber result = reduce (numbers, count, false, threadCount (threads, count / 2));
+  if (result.num_->n_scale < scale_)
+    {
+    const BigNumber zero;
+    bc_num padded = NULL;
+    bc_add (result.num_, zero.num_, &padded, scale_);
+    bc_free_num (&result.num_);
+    result.num_ = padded;
+    }
+  return result;
+} // end of BigNumber::sum
+
+// The product of count numbers (one if there are none).  It is worked out
+// exactly, then cut to the larger of the current scale and the scales of
+// the numbers, so it is at least as accurate as multiplying them in turn.
+BigNumber BigNumber::product (const BigNumber * numbers, const size_t count, const int threads)
+{
+  if (count == 0)
+    return BigNumber (1);
+
+  int scale = scale_;
+  for (size_t i = 0; i < count; i++)
+    if (numbers [i].num_->n_scale > scale)
+      scale = numbers [i].num_->n_scale;
+
+  const BigNumber result = reduce (numbers, count, true, threadCount (threads, count / 2));
+  if (result.num_->n_scale <= scale)
+    return result;
+  return truncate (result, scale);
+} // end of BigNumber::product
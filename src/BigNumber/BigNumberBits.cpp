@@ -0,0 +1,199 @@
+//
+//  BigNumberBits.cpp
+//
+//  Bitwise operations on BigNumbers.
+//  Released into the public domain.
+//
+//  These work on the integer part of numbers, as two's complement integers
+//  of unlimited length (so -1 has every bit set, and ~n is -n - 1), which
+//  is how they behave in Python.
+//
+//  The digits are decimal, so there are no bits to work on directly.  And,
+//  or and xor convert both numbers to bytes (with the divide and conquer
+//  conversion in BigNumberRadix.cpp), combine the bytes and convert back.
+//  Shifts need no conversion and no division: n << k is n * 2^k, and
+//  n >> k is n * 5^k / 10^k, which is a multiply and a shift of the
+//  decimal digits.
+
+#include "BigNumber.h"
+
+extern "C"
+{
+ #include "bcconfig.h"
+}
+
+#include <stdlib.h>
+
+// ------------------------------- HELPERS --------------------------------
+
+// The integer part of the number in length bytes, least significant
+// first, in two's complement.  length must leave room for the sign bit.
+// The bytes are put in a buffer which the caller MUST FREE after use.
+uint8_t * BigNumber::twosComplement (const size_t length) const
+{
+  unsigned char * digits;
+  const size_t count = radixDigits (256, digits);
+
+  uint8_t * bytes = (uint8_t *) malloc (length);
+  if (bytes == NULL)
+    bc_out_of_memory ();
+  memset (bytes, 0, length);
+  for (size_t i = 0; i < count; i++)
+    bytes [i] = digits [count - 1 - i];
+  free (digits);
+
+  // -n is ~n + 1
+  if (isNegative ())
+    {
+    unsigned carry = 1;
+    for (size_t i = 0; i < length; i++)
+      {
+      carry += (uint8_t) ~bytes [i];
+      bytes [i] = (uint8_t) carry;
+      carry >>= 8;
+      }
+    }
+  return bytes;
+} // end of BigNumber::twosComplement
+
+// the integer in length two's complement bytes, least significant first
+// (the bytes are changed)
+BigNumber BigNumber::fromTwosComplement (uint8_t * bytes, const size_t length)
+{
+  const bool negative = length > 0 && (bytes [length - 1] & 0x80);
+  if (negative)
+    {
+    unsigned carry = 1;
+    for (size_t i = 0; i < length; i++)
+      {
+      carry += (uint8_t) ~bytes [i];
+      bytes [i] = (uint8_t) carry;
+      carry >>= 8;
+      }
+    }
+
+  BigNumber result = fromBytes (bytes, length, false);
+  if (negative)
+    bc_sub (BigNumber (0).num_, result.num_, &result.num_, 0);
+  return result;
+} // end of BigNumber::fromTwosComplement
+
+// a & b, a | b or a ^ b, byte by byte
+BigNumber BigNumber::bitwise (const BigNumber & a, const BigNumber & b, const char op)
+{
+  // bytes for the larger number, and one more for the sign
+  const size_t length = (a.num_->n_len > b.num_->n_len ? a.num_->n_len : b.num_->n_len)
+                        * 10 / 24 + 2;
+  uint8_t * x = a.twosComplement (length);
+  uint8_t * y = b.twosComplement (length);
+
+  for (size_t i = 0; i < length; i++)
+    switch (op)
+      {
+      case '&': x [i] &= y [i]; break;
+      case '|': x [i] |= y [i]; break;
+      default:  x [i] ^= y [i]; break;
+      }
+
+  const BigNumber result = fromTwosComplement (x, length);
+  free (x);
+  free (y);
+  return result;
+} // end of BigNumber::bitwise
+
+// ------------------------------ OPERATIONS ------------------------------
+
+BigNumber BigNumber::operator& (const BigNumber & n) const
+{
+  return bitwise (*this, n, '&');
+} // end of BigNumber::operator&
+
+BigNumber BigNumber::operator| (const BigNumber & n) const
+{
+  return bitwise (*this, n, '|');
+} // end of BigNumber::operator|
+
+BigNumber BigNumber::operator^ (const BigNumber & n) const
+{
+  return bitwise (*this, n, '^');
+} // end of BigNumber::operator^
+
+// -n - 1
+BigNumber BigNumber::operator~ () const
+{
+  const BigNumber minusOne (-1);
+  BigNumber result;
+  bc_sub (minusOne.num_, truncate (*this, 0).num_, &result.num_, 0);
+  return result;
+} // end of BigNumber::operator~
+
+// n * 2^bits
+BigNumber BigNumber::operator<< (const int bits) const
+{
+  if (bits < 0)
+    return *this >> - bits;
+
+  const int oldScale = setScale (0);
+  const BigNumber result = truncate (*this, 0) * BigNumber (2).pow (bits);
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::operator<<
+
+// n / 2^bits, rounded down (towards minus infinity, as for an arithmetic
+// shift), worked out as n * 5^bits / 10^bits
+BigNumber BigNumber::operator>> (const int bits) const
+{
+  if (bits < 0)
+    return *this << - bits;
+
+  const BigNumber n = truncate (*this, 0);
+  // 2^bits > 10^(bits * 0.3), so anything shorter than that shifts out
+  if ((long) n.num_->n_len * 10 < (long) bits * 3)
+    return n.isNegative () ? BigNumber (-1) : BigNumber (0);
+
+  const int oldScale = setScale (0);
+  const BigNumber product = n * BigNumber (5).pow (bits);
+  BigNumber result;
+  bc_shift_scale (product.num_, - bits, 0, &result.num_);
+  if (product.isNegative () && result.mulPow10 (bits) != product)
+    --result;
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::operator>>
+
+// ------------------------------ BIT QUERIES -----------------------------
+
+// the bits needed for the size of the integer part (zero for zero)
+long BigNumber::bitLength () const
+{
+  unsigned char * digits;
+  const size_t count = radixDigits (256, digits);
+  long bits = (long) (count - 1) * 8;
+  for (unsigned top = digits [0]; top > 0; top >>= 1)
+    bits++;
+  free (digits);
+  return bits;
+} // end of BigNumber::bitLength
+
+// bit bit (counting from zero) of the two's complement integer part
+bool BigNumber::testBit (const int bit) const
+{
+  if (bit < 0)
+    return false;
+  const BigNumber shifted = *this >> bit;
+  const bc_num num = shifted.num_;
+  return num->n_value [num->n_len - 1] & 1;
+} // end of BigNumber::testBit
+
+// the bits which are set in the size of the integer part
+long BigNumber::popCount () const
+{
+  unsigned char * digits;
+  const size_t count = radixDigits (256, digits);
+  long bits = 0;
+  for (size_t i = 0; i < count; i++)
+    for (unsigned byte = digits [i]; byte > 0; byte &= byte - 1)
+      bits++;
+  free (digits);
+  return bits;
+} // end of BigNumber::popCount
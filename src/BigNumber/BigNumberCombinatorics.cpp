@@ -0,0 +1,168 @@
+//
+//  BigNumberCombinatorics.cpp
+//
+//  Factorials, binomial coefficients and primorials for BigNumber.
+//  Released into the public domain.
+//
+//  All three are products of prime powers.  The primes come from a sieve
+//  and are multiplied together as a balanced tree, so the big multiplies
+//  are between numbers of about the same size, where Karatsuba helps most.
+//  Factorials use the "prime swing": n! = (n/2)!^2 * swing (n).
+
+#include "BigNumber.h"
+
+extern "C"
+{
+ #include "bcconfig.h"
+}
+
+#include <stdlib.h>
+
+// below this a factorial fits in a long
+static const long SMALL_FACTORIAL = 13;
+
+// A sieve of the odd numbers up to n: bit i is set if 2i + 1 is not prime.
+// MUST FREE IT after use.
+static unsigned char * makeSieve (const long n)
+{
+  const long size = n / 16 + 1;
+  unsigned char * sieve = (unsigned char *) malloc (size);
+  if (sieve == NULL)
+    bc_out_of_memory ();
+  memset (sieve, 0, size);
+  sieve [0] = 1;  // 1 is not prime
+
+  for (long p = 3; p <= n / p; p += 2)
+    if ((sieve [p / 16] & (1 << ((p / 2) & 7))) == 0)
+      for (long m = p * p; m <= n; m += 2 * p)
+        sieve [m / 16] |= 1 << ((m / 2) & 7);
+  return sieve;
+} // end of makeSieve
+
+static bool isPrime (const unsigned char * sieve, const long p)
+{
+  if (p < 3)
+    return p == 2;
+  return (p & 1) != 0 && (sieve [p / 16] & (1 << ((p / 2) & 7))) == 0;
+} // end of isPrime
+
+// the power of the prime p in the product
+int BigNumber::primePower (const PrimeProduct kind, const long p, const long n, const long k)
+{
+  int power = 0;
+  long m = n;
+  long a = k;
+  long b = n - k;
+  switch (kind)
+    {
+    // swing (n) = n! / (n/2)!^2: the parity of each term of Legendre's formula
+    case SWING_PRIMES:
+      while ((m /= p) > 0)
+        power += m & 1;
+      break;
+
+    // n! / (k! (n - k)!): the differences of Legendre's formula (Kummer)
+    case BINOMIAL_PRIMES:
+      while (m > 0)
+        {
+        m /= p;
+        a /= p;
+        b /= p;
+        power += m - a - b;
+        }
+      break;
+
+    default:
+      power = 1;
+      break;
+    }
+  return power;
+} // end of BigNumber::primePower
+
+// the product of the prime powers for the primes from low to high-1
+// Each prime power is at most n so fits in a long, and they are multiplied
+// together as longs for as long as they fit.
+BigNumber BigNumber::primeProduct (const unsigned char * sieve, const PrimeProduct kind,
+                                   const long n, const long k, const long low, const long high)
+{
+  if (high - low > 64)
+    {
+    const long mid = low + (high - low) / 2;
+    return primeProduct (sieve, kind, n, k, low, mid) * primeProduct (sieve, kind, n, k, mid, high);
+    }
+
+  BigNumber result = 1;
+  long product = 1;
+  for (long p = low; p < high; p++)
+    {
+    if (!isPrime (sieve, p))
+      continue;
+    long factor = 1;
+    for (int power = primePower (kind, p, n, k); power > 0; power--)
+      factor *= p;
+    if (factor > 2147483647L / product)
+      {
+      result *= fromLong (product);
+      product = 1;
+      }
+    product *= factor;
+    }
+  return result * fromLong (product);
+} // end of BigNumber::primeProduct
+
+// n! = (n/2)!^2 * swing (n)
+BigNumber BigNumber::factorialSwing (const unsigned char * sieve, const long n)
+{
+  if (n < SMALL_FACTORIAL)
+    {
+    long result = 1;
+    for (long i = 2; i <= n; i++)
+      result *= i;
+    return fromLong (result);
+    }
+
+  const BigNumber half = factorialSwing (sieve, n / 2);
+  return half * half * primeProduct (sieve, SWING_PRIMES, n, 0, 2, n + 1);
+} // end of BigNumber::factorialSwing
+
+// n!
+BigNumber BigNumber::factorial (const long n)
+{
+  if (n < 0)
+    return BigNumber (0);
+  if (n < SMALL_FACTORIAL)
+    return factorialSwing (NULL, n);
+
+  unsigned char * sieve = makeSieve (n);
+  const BigNumber result = factorialSwing (sieve, n);
+  free (sieve);
+  return result;
+} // end of BigNumber::factorial
+
+// n! / (k! (n - k)!)
+BigNumber BigNumber::binomial (const long n, long k)
+{
+  if (n < 0 || k < 0 || k > n)
+    return BigNumber (0);
+  if (k > n - k)
+    k = n - k;
+  if (k == 0)
+    return BigNumber (1);
+
+  unsigned char * sieve = makeSieve (n);
+  const BigNumber result = primeProduct (sieve, BINOMIAL_PRIMES, n, k, 2, n + 1);
+  free (sieve);
+  return result;
+} // end of BigNumber::binomial
+
+// the product of the primes up to n
+BigNumber BigNumber::primorial (const long n)
+{
+  if (n < 2)
+    return BigNumber (1);
+
+  unsigned char * sieve = makeSieve (n);
+  const BigNumber result = primeProduct (sieve, ALL_PRIMES, n, 0, 2, n + 1);
+  free (sieve);
+  return result;
+} // end of BigNumber::primorial
@@ -0,0 +1,210 @@
+//
+//  BigNumberDouble.cpp
+//
+//  Conversion between BigNumbers and floating point, without going
+//  through strings.
+//  Released into the public domain.
+//
+//  Every finite double is an integer times a power of two, m * 2^e, which
+//  is exactly m * 5^-e / 10^-e when e is negative, so it has an exact
+//  decimal value.  Going the other way, a first guess from the leading
+//  digits is checked against the exact halfway points between it and its
+//  neighbours, so the result is correctly rounded.
+
+#include "BigNumber.h"
+
+#include <float.h>
+
+// the smallest power of two of a unit in the last place (for subnormals)
+static const int MIN_ULP_EXPONENT = DBL_MIN_EXP - DBL_MANT_DIG;
+
+// 2^n exactly, for any n
+BigNumber BigNumber::powerOfTwo (const int n)
+{
+  const int oldScale = setScale (0);
+  BigNumber result;
+  if (n >= 0)
+    result = BigNumber (2).pow (BigNumber (n));
+  else
+    result = shift (BigNumber (5).pow (BigNumber (-n)), n);
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::powerOfTwo
+
+// The exact value of a finite double.  The integer part of its mantissa is
+// put together from two longs, as a long may only be 32 bits.
+BigNumber BigNumber::exactDouble (const double d)
+{
+  if (d == 0)
+    return BigNumber (0);
+
+  int e;
+  double m = ldexp (frexp (fabs (d), &e), DBL_MANT_DIG);  // an integer below 2^DBL_MANT_DIG
+  e -= DBL_MANT_DIG;
+  while (fmod (m, 2) == 0)
+    {
+    m /= 2;
+    e++;
+    }
+
+  const double high = floor (ldexp (m, -26));
+  const double low = m - ldexp (high, 26);
+
+  const int oldScale = setScale (0);
+  BigNumber result = fromLong ((long) high) * powerOfTwo (26) + fromLong ((long) low);
+  result *= powerOfTwo (e);
+  if (d < 0)
+    result = BigNumber (0) - result;
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::exactDouble
+
+// the power of two of a unit in the last place of a positive finite double
+static int ulpExponent (const double d)
+{
+  int e;
+  frexp (d, &e);
+  return e - DBL_MANT_DIG < MIN_ULP_EXPONENT ? MIN_ULP_EXPONENT : e - DBL_MANT_DIG;
+} // end of ulpExponent
+
+// the powers of two of the gaps to the doubles above and below a positive
+// finite double
+static void doubleGaps (const double d, int & above, int & below)
+{
+  int e;
+  const double m = frexp (d, &e);
+  above = ulpExponent (d);
+  below = (m == 0.5 && above > MIN_ULP_EXPONENT) ? above - 1 : above;
+} // end of doubleGaps
+
+// A double as a BigNumber: its exact value, or if shortest, the shortest
+// decimal which converts back to the same double.  NaN and infinities
+// give zero.
+BigNumber BigNumber::fromDouble (const double d, const bool shortest)
+{
+  if (d != d || d - d != 0)
+    return BigNumber (0);
+
+  const BigNumber exact = exactDouble (d);
+  if (!shortest || d == 0)
+    return exact;
+
+  // the numbers between low and high convert to d, and so do low and high
+  // themselves if the mantissa of d is even (halfway cases go to even)
+  const BigNumber v = d < 0 ? BigNumber (0) - exact : exact;
+  int above, below;
+  doubleGaps (fabs (d), above, below);
+  const BigNumber high = v + powerOfTwo (above - 1);
+  const BigNumber low = v - powerOfTwo (below - 1);
+  const bool even = fmod (ldexp (fabs (d), - above), 2) == 0;
+
+  // try more and more significant digits, rounding v down and up
+  const int leading = decimalExponent (v.num_);
+  BigNumber result = v;
+  for (int digits = 1; digits <= DBL_DIG + 3; digits++)
+    {
+    const int places = digits - 1 - leading;
+    const int oldScale = setScale (places > 0 ? places : 0);
+    const BigNumber down = shift (truncate (shift (v, places), 0), -places);
+    const BigNumber up = down + shift (BigNumber (1), -places);
+    const bool downFits = down > low || (even && down == low);
+    const bool upFits = up < high || (even && up == high);
+    setScale (oldScale);
+
+    if (downFits || upFits)
+      {
+      if (downFits && (!upFits || v - down <= up - v))
+        result = down;
+      else
+        result = up;
+      break;
+      }
+    }
+
+  if (d < 0)
+    {
+    const int oldScale = setScale (0);  // keep the digits found
+    result = BigNumber (0) - result;
+    setScale (oldScale);
+    }
+  return result;
+} // end of BigNumber::fromDouble
+
+// The nearest double to the number (halfway cases go to the even one).
+// A first guess is made from the leading digits, then moved while the
+// number is past the halfway point to the next double, which usually only
+// needs the leading digits of the number to decide.
+double BigNumber::toDouble () const
+{
+  if (isZero ())
+    return 0;
+
+  const int exponent = decimalExponent (num_);
+  if (exponent > DBL_MAX_10_EXP + 1)
+    return isNegative () ? -HUGE_VAL : HUGE_VAL;
+  if (exponent < DBL_MIN_10_EXP - DBL_DIG - 3)
+    return isNegative () ? -0.0 : 0.0;
+
+  // the first guess, from up to 17 digits, scaled in two steps so a
+  // subnormal does not underflow on the way
+  const char * digit = num_->n_value + num_->n_len - 1 - exponent;
+  const char * end = num_->n_value + num_->n_len + num_->n_scale;
+  double guess = 0;
+  int digits = 0;
+  for ( ; digits < 17 && digit < end; digits++)
+    guess = guess * 10 + *digit++;
+  const int power = exponent - digits + 1;
+  guess *= ::pow (10.0, power / 2);
+  guess *= ::pow (10.0, power - power / 2);
+
+  const int oldScale = setScale (0);
+  BigNumber x = *this;
+  if (x.isNegative ())
+    x = BigNumber (0) - x;
+
+  if (guess > DBL_MAX)
+    guess = DBL_MAX;
+
+  for (;;)
+    {
+    int above, below;
+    doubleGaps (guess, above, below);
+
+    const BigNumber g = exactDouble (guess);
+    BigNumber mid;
+    double next;
+    if (x > g)
+      {
+      next = guess + ldexp (1.0, above);
+      mid = g + powerOfTwo (above - 1);
+      }
+    else if (x < g && guess > 0)
+      {
+      next = guess - ldexp (1.0, below);
+      mid = g - powerOfTwo (below - 1);
+      }
+    else
+      break;
+
+    // past the halfway point, move on; at it, take the even mantissa
+    // (which past the largest double is infinity)
+    const int side = bc_compare (x.num_, mid.num_) * (next > guess ? 1 : -1);
+    if (side < 0)
+      break;
+    if (next > DBL_MAX)
+      {
+      guess = HUGE_VAL;
+      break;
+      }
+    if (side == 0)
+      {
+      if (fmod (ldexp (next, - ulpExponent (next)), 2) == 0)
+        guess = next;
+      break;
+      }
+    guess = next;
+    }
+
+  setScale (oldScale);
+  return isNegative () ? -guess : guess;
+} // end of BigNumber::toDouble
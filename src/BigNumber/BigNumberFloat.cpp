@@ -0,0 +1,396 @@
+//
+//  BigNumberFloat.cpp
+//
+//  Decimal floating point: a mantissa and a power of ten.
+//  Released into the public domain.
+//
+//  A BigFloat is an integer mantissa, with no zeros at the end, times
+//  10^exponent, so 1e5000 and 1e-5000 are each one digit and an exponent,
+//  where a BigNumber needs 5001 digits, or a scale of 5000.  Results are
+//  truncated (towards zero, like BigNumber) to the number of significant
+//  digits set by setDigits, which plays the part of the scale.  Within
+//  that they are exact: each operation works out just enough digits of
+//  the exact result, with the BigNumber operations on the mantissas, and
+//  drops the rest.
+//
+//  When adding numbers of very different sizes, the smaller one can only
+//  matter through its sign (which way the sum is truncated), so it is
+//  replaced by a single digit just below the digits which can be kept,
+//  rather than lining up thousands of zeros.
+
+#include "BigNumber.h"
+
+extern "C"
+{
+ #include "bcconfig.h"
+}
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if BIGNUMBER_THREADS
+thread_local int BigFloat::digits_ = 20;
+#else
+int BigFloat::digits_ = 20;
+#endif
+
+// Set the significant digits of results (at least one), returning the
+// previous number.
+int BigFloat::setDigits (const int digits)
+{
+  const int old = digits_;
+  digits_ = digits > 0 ? digits : 1;
+  return old;
+} // end of BigFloat::setDigits
+
+// ------------------------------- HELPERS --------------------------------
+
+// the digits of an integer
+int BigFloat::length (const BigNumber & n)
+{
+  return n.num_->n_len;
+} // end of BigFloat::length
+
+// an integer without its last count digits
+BigNumber BigFloat::dropDigits (const BigNumber & n, const long count)
+{
+  if (count <= 0)
+    return n;
+  if (count >= length (n))
+    return BigNumber (0);
+  return BigNumber::truncate (BigNumber::shift (n, (int) - count), 0);
+} // end of BigFloat::dropDigits
+
+// -n (BigNumber has no unary minus)
+BigNumber BigFloat::negate (const BigNumber & n)
+{
+  BigNumber result;
+  bc_sub (BigNumber (0).num_, n.num_, &result.num_, 0);
+  return result;
+} // end of BigFloat::negate
+
+// an integer with count zeros added at the end
+BigNumber BigFloat::addZeros (const BigNumber & n, const long count)
+{
+  if (count <= 0)
+    return n;
+  return BigNumber::shift (n, (int) count);
+} // end of BigFloat::addZeros
+
+// the power of ten of the leading digit (of a number which is not zero)
+long BigFloat::top (const BigFloat & x)
+{
+  return x.exponent_ + length (x.mantissa_) - 1;
+} // end of BigFloat::top
+
+// Truncate the mantissa to the significant digits, and take the zeros off
+// its end.
+void BigFloat::normalize ()
+{
+  const int extra = length (mantissa_) - digits_;
+  if (extra > 0)
+    {
+    mantissa_ = dropDigits (mantissa_, extra);
+    exponent_ += extra;
+    }
+
+  if (mantissa_.isZero ())
+    {
+    exponent_ = 0;
+    return;
+    }
+  const bc_num num = mantissa_.num_;
+  int zeros = 0;
+  while (zeros < num->n_len - 1 && num->n_value [num->n_len - 1 - zeros] == 0)
+    zeros++;
+  if (zeros > 0)
+    {
+    mantissa_ = dropDigits (mantissa_, zeros);
+    exponent_ += zeros;
+    }
+} // end of BigFloat::normalize
+
+// ---------------------------- CONSTRUCTORS ------------------------------
+
+BigFloat::BigFloat () : mantissa_ (0), exponent_ (0)
+{
+} // end of BigFloat::BigFloat
+
+BigFloat::BigFloat (const int n) : mantissa_ (n), exponent_ (0)
+{
+  normalize ();
+} // end of BigFloat::BigFloat
+
+// all the digits of n, then truncated to the significant digits
+BigFloat::BigFloat (const BigNumber & n) : exponent_ (- n.num_->n_scale)
+{
+  bc_shift_num (n.num_, n.num_->n_scale, &mantissa_.num_);
+  normalize ();
+} // end of BigFloat::BigFloat
+
+// mantissa (truncated to an integer) * 10^exponent
+BigFloat::BigFloat (const BigNumber & mantissa, const long exponent)
+  : mantissa_ (BigNumber::truncate (mantissa, 0)), exponent_ (exponent)
+{
+  normalize ();
+} // end of BigFloat::BigFloat
+
+// A number like "-12.5", "1e5000" or "1.5E-7".  Anything else gives zero.
+BigFloat::BigFloat (const char * s) : mantissa_ (0), exponent_ (0)
+{
+  const bool negative = *s == '-';
+  if (*s == '-' || *s == '+')
+    s++;
+
+  const char * whole = s;
+  while (*s >= '0' && *s <= '9')
+    s++;
+  const size_t wholeLength = s - whole;
+  const char * fraction = s;
+  size_t fractionLength = 0;
+  if (*s == '.')
+    {
+    fraction = ++s;
+    while (*s >= '0' && *s <= '9')
+      s++;
+    fractionLength = s - fraction;
+    }
+  if (wholeLength + fractionLength == 0)
+    return;
+
+  long exponent = 0;
+  if (*s == 'e' || *s == 'E')
+    {
+    char * end;
+    exponent = strtol (s + 1, &end, 10);
+    if (end == s + 1)
+      return;
+    s = end;
+    }
+  if (*s != 0)
+    return;
+
+  // the digits of the mantissa, without the point
+  const int oldScale = BigNumber::setScale (0);
+  BigNumber high, low;
+  if (wholeLength > 0)
+    BigNumber::parse (whole, wholeLength, high);
+  if (fractionLength > 0)
+    BigNumber::parse (fraction, fractionLength, low);
+  BigNumber::setScale (oldScale);
+
+  bc_add (addZeros (high, fractionLength).num_, low.num_, &mantissa_.num_, 0);
+  if (negative)
+    mantissa_ = negate (mantissa_);
+  exponent_ = exponent - (long) fractionLength;
+  normalize ();
+} // end of BigFloat::BigFloat
+
+// ----------------------------- CONVERSIONS ------------------------------
+
+// the exact value (with as many digits as the exponent needs)
+BigNumber BigFloat::toBigNumber () const
+{
+  if (exponent_ >= 0)
+    return addZeros (mantissa_, exponent_);
+  return BigNumber::shift (mantissa_, (int) exponent_);
+} // end of BigFloat::toBigNumber
+
+// As "-d.ddde-n" (or without the exponent if it is zero).  MUST FREE IT
+// after use!
+char * BigFloat::toString () const
+{
+  char * digits = mantissa_.toString ();
+  const char * first = digits [0] == '-' ? digits + 1 : digits;
+  const size_t count = strlen (first);
+  char * result = (char *) malloc (count + 32);
+  if (result == NULL)
+    bc_out_of_memory ();
+
+  char * p = result;
+  if (first != digits)
+    *p++ = '-';
+  *p++ = first [0];
+  if (count > 1)
+    {
+    *p++ = '.';
+    memcpy (p, first + 1, count - 1);
+    p += count - 1;
+    }
+  *p = 0;
+  if (!isZero () && top (*this) != 0)
+    sprintf (p, "e%ld", top (*this));
+  free (digits);
+  return result;
+} // end of BigFloat::toString
+
+size_t BigFloat::printTo (Print & p) const
+{
+  char * s = toString ();
+  const size_t length = p.write ((const uint8_t *) s, strlen (s));
+  free (s);
+  return length;
+} // end of BigFloat::printTo
+
+bool BigFloat::isZero () const
+{
+  return mantissa_.isZero ();
+} // end of BigFloat::isZero
+
+bool BigFloat::isNegative () const
+{
+  return mantissa_.isNegative ();
+} // end of BigFloat::isNegative
+
+// ------------------------------ OPERATIONS ------------------------------
+
+BigFloat BigFloat::operator- () const
+{
+  BigFloat result = *this;
+  result.mantissa_ = negate (mantissa_);
+  return result;
+} // end of BigFloat::operator-
+
+// a + b, or a - b, truncated
+BigFloat BigFloat::sum (const BigFloat & a, const BigFloat & b, const bool subtract)
+{
+  BigFloat y = subtract ? - b : b;
+  if (a.isZero () || y.isZero ())
+    {
+    BigFloat result = a.isZero () ? y : a;
+    result.normalize ();
+    return result;
+    }
+
+  // x is the one with the higher leading digit
+  BigFloat x = a;
+  if (top (y) > top (x))
+    {
+    x = y;
+    y = a;
+    }
+
+  // The result is truncated at or above the place top (x) - digits_, and
+  // x has no digits below its exponent, so a y wholly below both can
+  // only make a difference through its sign.
+  long below = top (x) - digits_ < x.exponent_ ? top (x) - digits_ : x.exponent_;
+  below -= 2;
+  if (top (y) < below)
+    {
+    y.mantissa_ = y.isNegative () ? -1 : 1;
+    y.exponent_ = below - 1;
+    }
+
+  const long exponent = x.exponent_ < y.exponent_ ? x.exponent_ : y.exponent_;
+  BigFloat result;
+  bc_add (addZeros (x.mantissa_, x.exponent_ - exponent).num_,
+          addZeros (y.mantissa_, y.exponent_ - exponent).num_, &result.mantissa_.num_, 0);
+  result.exponent_ = exponent;
+  result.normalize ();
+  return result;
+} // end of BigFloat::sum
+
+BigFloat BigFloat::operator+ (const BigFloat & rhs) const
+{
+  return sum (*this, rhs, false);
+} // end of BigFloat::operator+
+
+BigFloat BigFloat::operator- (const BigFloat & rhs) const
+{
+  return sum (*this, rhs, true);
+} // end of BigFloat::operator-
+
+// The mantissas as fractions (0.ddd), multiplied to one more place than
+// the digits wanted, so the product is at least 0.01 and has enough
+// digits, and the multiply can skip the ones which will be dropped.
+BigFloat BigFloat::operator* (const BigFloat & rhs) const
+{
+  const int la = length (mantissa_);
+  const int lb = length (rhs.mantissa_);
+  const BigNumber fa = BigNumber::shift (mantissa_, - la);
+  const BigNumber fb = BigNumber::shift (rhs.mantissa_, - lb);
+
+  BigFloat result;
+  bc_multiply (fa.num_, fb.num_, &result.mantissa_.num_, digits_ + 1);
+  const int scale = result.mantissa_.num_->n_scale;
+  result.mantissa_ = BigNumber::shift (result.mantissa_, scale);
+  result.exponent_ = exponent_ + rhs.exponent_ + la + lb - scale;
+  result.normalize ();
+  return result;
+} // end of BigFloat::operator*
+
+// the dividend's mantissa, with enough zeros added to give a quotient of
+// more than the digits wanted, divided as integers
+BigFloat BigFloat::operator/ (const BigFloat & rhs) const
+{
+  if (rhs.isZero ())
+    return BigFloat ();
+
+  const int la = length (mantissa_);
+  const int lb = length (rhs.mantissa_);
+  const long zeros = digits_ + lb - la + 1 > 0 ? digits_ + lb - la + 1 : 0;
+
+  BigFloat result;
+  bc_divide (addZeros (mantissa_, zeros).num_, rhs.mantissa_.num_, &result.mantissa_.num_, 0);
+  result.exponent_ = exponent_ - rhs.exponent_ - zeros;
+  result.normalize ();
+  return result;
+} // end of BigFloat::operator/
+
+// The integer square root of the mantissa, with an even number of zeros
+// added to give more than the digits wanted (and an even exponent).
+// Negative numbers give zero.
+BigFloat BigFloat::sqrt () const
+{
+  if (isZero () || isNegative ())
+    return BigFloat ();
+
+  BigNumber m = mantissa_;
+  long exponent = exponent_;
+  if (exponent % 2 != 0)
+    {
+    m = addZeros (m, 1);
+    exponent--;
+    }
+  const int half = (length (m) + 1) / 2;
+  const long pairs = digits_ + 1 - half > 0 ? digits_ + 1 - half : 0;
+  m = addZeros (m, 2 * pairs);
+  exponent -= 2 * pairs;
+
+  // bc_sqrt is close: make it the largest r with r^2 <= m
+  BigNumber root = m;
+  bc_sqrt (&root.num_, 0);
+  const BigNumber one (1);
+  BigNumber square;
+  bc_multiply (root.num_, root.num_, &square.num_, 0);
+  while (square > m)
+    {
+    bc_sub (root.num_, one.num_, &root.num_, 0);
+    bc_multiply (root.num_, root.num_, &square.num_, 0);
+    }
+  for (;;)
+    {
+    BigNumber next;
+    bc_add (root.num_, one.num_, &next.num_, 0);
+    bc_multiply (next.num_, next.num_, &square.num_, 0);
+    if (square > m)
+      break;
+    root = next;
+    }
+
+  BigFloat result;
+  result.mantissa_ = root;
+  result.exponent_ = exponent / 2;
+  result.normalize ();
+  return result;
+} // end of BigFloat::sqrt
+
+// -1, 0 or 1 as a is below, equal to or above b
+int BigFloat::compare (const BigFloat & a, const BigFloat & b)
+{
+  const BigFloat difference = sum (a, b, true);
+  if (difference.isZero ())
+    return 0;
+  return difference.isNegative () ? -1 : 1;
+} // end of BigFloat::compare
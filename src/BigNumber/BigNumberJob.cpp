@@ -0,0 +1,249 @@
+//
+//  BigNumberJob.cpp
+//
+//  Operations done a little at a time, so that a single threaded loop
+//  (eg. an Arduino loop ()) can go on with other things in between.
+//  Released into the public domain.
+//
+//  Each job keeps the state of its operation between steps.  The long
+//  divisions are done with bc_divide_start / bc_divide_step, which can stop
+//  after any quotient digit; a multiply is always done in one go, so a step
+//  can run over its budget by up to one multiply.  The jobs follow the same
+//  steps as bc_divide, bc_raisemod and bc_sqrt, so they give the same
+//  results as the operations done in one go.
+
+#include "BigNumber.h"
+
+#include <limits.h>
+
+// the budget of each step of stepFor
+static const long SLICE_BUDGET = 500;
+
+// Do about budget digit operations of the job.  Returns true once the
+// result is ready.
+bool BigNumberJob::step (const long budget)
+{
+  if (!finished_)
+    {
+    long left = budget > 0 ? budget : 1;
+    finished_ = work (left);
+    }
+  return finished_;
+} // end of BigNumberJob::step
+
+// Take small steps for about us microseconds (or until it is finished).
+bool BigNumberJob::stepFor (const unsigned long us)
+{
+  const unsigned long start = micros ();
+  while (!step (SLICE_BUDGET))
+    if (micros () - start >= us)
+      return false;
+  return true;
+} // end of BigNumberJob::stepFor
+
+// about the digit operations of multiplying n1 by n2
+long BigNumberJob::multiplyCost (const bc_num n1, const bc_num n2)
+{
+  const double cost = (double) (n1->n_len + n1->n_scale) * (n2->n_len + n2->n_scale);
+  return cost < LONG_MAX ? (long) cost : LONG_MAX;
+} // end of BigNumberJob::multiplyCost
+
+// ------------------------------- DIVISION -------------------------------
+
+BigNumberDivideJob::BigNumberDivideJob (const BigNumber & x, const BigNumber & y)
+{
+  dividing_ = bc_divide_start (&state_, num (x), num (y), currentScale ()) == 0;
+} // end of BigNumberDivideJob::BigNumberDivideJob
+
+BigNumberDivideJob::~BigNumberDivideJob ()
+{
+  if (dividing_)
+    bc_divide_abandon (&state_);
+} // end of BigNumberDivideJob::~BigNumberDivideJob
+
+bool BigNumberDivideJob::work (long & budget)
+{
+  if (!dividing_)
+    return true;
+  if (!bc_divide_step (&state_, &budget))
+    return false;
+  bc_divide_finish (&state_, &num (result_));
+  dividing_ = false;
+  return true;
+} // end of BigNumberDivideJob::work
+
+// ------------------------------ POWER MOD -------------------------------
+
+BigNumberPowModJob::BigNumberPowModJob (const BigNumber & x, const BigNumber & power,
+                                        const BigNumber & modulus)
+  : stage_ (HALVE), scale_ (currentScale ()), rscale_ (0)
+{
+  // with a zero exponent, the first step finishes with the result (zero)
+  if (bc_is_zero (num (modulus)) || bc_is_neg (num (power)))
+    return;
+
+  power_ = x;
+  bc_divide (num (power), num (BigNumber (1)), &num (exponent_), 0);
+  modulus_ = modulus;
+  result_ = 1;
+  rscale_ = scale_ > num (x)->n_scale ? scale_ : num (x)->n_scale;
+} // end of BigNumberPowModJob::BigNumberPowModJob
+
+BigNumberPowModJob::~BigNumberPowModJob ()
+{
+  if (stage_ != HALVE)
+    bc_divide_abandon (&state_);
+} // end of BigNumberPowModJob::~BigNumberPowModJob
+
+// start dividing n by the modulus
+void BigNumberPowModJob::startModulo (const BigNumber & n)
+{
+  dividend_ = n;
+  bc_divide_start (&state_, num (dividend_), num (modulus_), scale_);
+} // end of BigNumberPowModJob::startModulo
+
+// the remainder once the division is done, as bc_divmod
+BigNumber BigNumberPowModJob::finishModulo ()
+{
+  BigNumber quotient, product, remainder;
+  bc_divide_finish (&state_, &num (quotient));
+  const int d = num (dividend_)->n_scale;
+  const int m = num (modulus_)->n_scale + scale_;
+  const int rscale = d > m ? d : m;
+  bc_multiply (num (quotient), num (modulus_), &num (product), rscale);
+  bc_sub (num (dividend_), num (product), &num (remainder), rscale);
+  return remainder;
+} // end of BigNumberPowModJob::finishModulo
+
+// Right to left binary powers: for each bit of the exponent, from the
+// bottom, multiply the result by the power if it is set, then square the
+// power, reducing both by the modulus.
+bool BigNumberPowModJob::work (long & budget)
+{
+  while (budget > 0)
+    switch (stage_)
+      {
+      case HALVE:
+        {
+        if (bc_is_zero (num (exponent_)))
+          return true;
+        const BigNumber two (2);
+        BigNumber parity;
+        budget -= num (exponent_)->n_len;
+        bc_divmod (num (exponent_), num (two), &num (exponent_), &num (parity), 0);
+        if (!parity.isZero ())
+          {
+          budget -= multiplyCost (num (result_), num (power_));
+          bc_multiply (num (result_), num (power_), &num (result_), rscale_);
+          startModulo (result_);
+          stage_ = REDUCE_RESULT;
+          }
+        else
+          {
+          budget -= multiplyCost (num (power_), num (power_));
+          bc_multiply (num (power_), num (power_), &num (power_), rscale_);
+          startModulo (power_);
+          stage_ = REDUCE_POWER;
+          }
+        break;
+        }
+
+      case REDUCE_RESULT:
+        if (!bc_divide_step (&state_, &budget))
+          return false;
+        result_ = finishModulo ();
+        stage_ = HALVE;
+        if (bc_is_zero (num (exponent_)))
+          return true;
+        budget -= multiplyCost (num (power_), num (power_));
+        bc_multiply (num (power_), num (power_), &num (power_), rscale_);
+        startModulo (power_);
+        stage_ = REDUCE_POWER;
+        break;
+
+      case REDUCE_POWER:
+        if (!bc_divide_step (&state_, &budget))
+          return false;
+        power_ = finishModulo ();
+        stage_ = HALVE;
+        break;
+      }
+  return false;
+} // end of BigNumberPowModJob::work
+
+// ------------------------------ SQUARE ROOT -----------------------------
+
+BigNumberSqrtJob::BigNumberSqrtJob (const BigNumber & x)
+  : x_ (x), dividing_ (false), cscale_ (0), rscale_ (-1)
+{
+  // a negative rscale_ means the result is known already
+  if (x <= BigNumber (0))
+    return;
+  const int cmp = bc_compare (num (x), num (BigNumber (1)));
+  if (cmp == 0)
+    {
+    result_ = 1;
+    return;
+    }
+
+  const int scale = currentScale ();
+  rscale_ = scale > num (x)->n_scale ? scale : num (x)->n_scale;
+  if (cmp < 0)
+    {
+    // between 0 and 1: start at 1
+    guess_ = 1;
+    cscale_ = num (x)->n_scale;
+    }
+  else
+    {
+    // start at 10^(digits/2)
+    bc_raise (num (BigNumber (10)), num (BigNumber (num (x)->n_len / 2)), &num (guess_), 0);
+    cscale_ = 3;
+    }
+} // end of BigNumberSqrtJob::BigNumberSqrtJob
+
+BigNumberSqrtJob::~BigNumberSqrtJob ()
+{
+  if (dividing_)
+    bc_divide_abandon (&state_);
+} // end of BigNumberSqrtJob::~BigNumberSqrtJob
+
+// Newton's method: guess = (guess + x / guess) / 2, to cscale_ places, and
+// once that settles, to more places until it settles at rscale_ + 1.
+bool BigNumberSqrtJob::work (long & budget)
+{
+  if (rscale_ < 0)
+    return true;
+
+  BigNumber half, diff;
+  bc_str2num (&num (half), "0.5", 1);
+  while (budget > 0)
+    {
+    if (!dividing_)
+      {
+      previous_ = guess_;
+      bc_divide_start (&state_, num (x_), num (guess_), cscale_);
+      dividing_ = true;
+      }
+    if (!bc_divide_step (&state_, &budget))
+      return false;
+    bc_divide_finish (&state_, &num (guess_));
+    dividing_ = false;
+
+    budget -= num (guess_)->n_len + cscale_;
+    bc_add (num (guess_), num (previous_), &num (guess_), 0);
+    bc_multiply (num (guess_), num (half), &num (guess_), cscale_);
+    bc_sub (num (guess_), num (previous_), &num (diff), cscale_ + 1);
+    if (bc_is_near_zero (num (diff), cscale_))
+      {
+      if (cscale_ < rscale_ + 1)
+        cscale_ = cscale_ * 3 < rscale_ + 1 ? cscale_ * 3 : rscale_ + 1;
+      else
+        {
+        bc_divide (num (guess_), num (BigNumber (1)), &num (result_), rscale_);
+        return true;
+        }
+      }
+    }
+  return false;
+} // end of BigNumberSqrtJob::work
@@ -0,0 +1,905 @@
+//
+//  BigNumberMath.cpp
+//
+//  Exponential, logarithm and trigonometric functions for BigNumber.
+//  Released into the public domain.
+//
+//  The series are summed by binary splitting: the terms are combined as
+//  exact integer fractions, with one division at the end, rather than a
+//  full precision division for every term.
+//
+//  Everything is worked out to the current scale plus some guard digits,
+//  then truncated, like the other operations.
+
+#include "BigNumber.h"
+
+extern "C"
+{
+ #include "bcconfig.h"
+}
+
+#include <limits.h>
+
+// extra digits carried to absorb rounding in the series and reductions
+static const int GUARD_DIGITS = 10;
+
+// With more terms than this left, the constants split the two halves of a
+// series between threads (with BIGNUMBER_THREADS); below it the threads
+// would cost more than they save.
+static const long THREAD_SPLIT_TERMS = 256;
+
+// the constants worked out so far, and their scales
+static bc_num piCache, eCache, ln2Cache, sqrt2Cache, ln10Cache;
+static int piScale, eScale, ln2Scale, sqrt2Scale, ln10Scale;
+
+// with threads the caches are shared behind a lock, which is held only
+// to look at or change them, not while working a constant out
+#if BIGNUMBER_THREADS
+ #include <mutex>
+ static std::mutex cacheMutex;
+ #define CACHE_LOCK std::lock_guard<std::mutex> cacheLock (cacheMutex)
+#else
+ #define CACHE_LOCK
+#endif
+
+// number of decimal digits in n
+static int digitCount (long n)
+{
+  int count = 1;
+  if (n < 0)
+    n = -n;
+  while (n >= 10)
+    {
+    n /= 10;
+    count++;
+    }
+  return count;
+} // end of digitCount
+
+// the power of ten of the first significant digit of a number (zero for
+// zero, which has none)
+int BigNumber::decimalExponent (const bc_num num)
+{
+  if (num->n_len > 1 || num->n_value [0] != 0)
+    return num->n_len - 1;
+  if (bc_is_zero (num))
+    return 0;
+
+  int exponent = 0;
+  const char * p = num->n_value + 1;
+  do
+    exponent--;
+  while (*p++ == 0);
+  return exponent;
+} // end of BigNumber::decimalExponent
+
+// log10 of the size of a number, from its leading digits (minus infinity
+// for zero)
+double BigNumber::log10Magnitude (const bc_num num)
+{
+  if (bc_is_zero (num))
+    return - HUGE_VAL;
+  const int exponent = decimalExponent (num);
+  const char * digit = num->n_value + num->n_len - 1 - exponent;
+  const char * end = num->n_value + num->n_len + num->n_scale;
+  double leading = 0;
+  for (int i = 0; i < 8; i++)
+    leading = leading * 10 + (digit < end ? *digit++ : 0);
+  return log10 (leading) - 7 + exponent;
+} // end of BigNumber::log10Magnitude
+
+// n times 10 to the power places (linear time, no digits lost)
+BigNumber BigNumber::shift (const BigNumber & n, const int places)
+{
+  BigNumber result;
+  bc_shift_num (n.num_, places, &result.num_);
+  return result;
+} // end of BigNumber::shift
+
+// drop the digits after scale decimal places
+BigNumber BigNumber::truncate (const BigNumber & n, const int scale)
+{
+  const BigNumber one (1);
+  BigNumber result;
+  bc_divide (n.num_, one.num_, &result.num_, scale);
+  return result;
+} // end of BigNumber::truncate
+
+// the digits from place start + 1 to place end after the decimal point of x,
+// as an integer
+BigNumber BigNumber::piece (const BigNumber & x, const int start, const int end)
+{
+  const int oldScale = setScale (0);
+  const BigNumber result = truncate (shift (x, end), 0) - shift (truncate (shift (x, start), 0), end - start);
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::piece
+
+// a long as a BigNumber, built up from ints as an int may only be 16 bits
+BigNumber BigNumber::fromLong (const long n)
+{
+  if (n > -10000 && n < 10000)
+    return BigNumber (int (n));
+
+  const int oldScale = setScale (0);
+  const BigNumber result = shift (fromLong (n / 10000), 4) + BigNumber (int (n % 10000));
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::fromLong
+
+// a floating point value (less than 20 in size) to 8 decimal places, as a
+// first guess for Newton's method
+BigNumber BigNumber::guess (const double value)
+{
+  return shift (fromLong (long (value * 1e8)), -8);
+} // end of BigNumber::guess
+
+// the denominator of the ratio between term n and term n-1 of a series
+long BigNumber::seriesDenominator (const SeriesKind kind, const long n)
+{
+  switch (kind)
+    {
+    case SIN_SERIES: return 2 * n * (2 * n + 1);
+    case COS_SERIES: return (2 * n - 1) * 2 * n;
+    default:         return n;
+    }
+} // end of BigNumber::seriesDenominator
+
+// ----------------------------- SERIES SUMS ------------------------------
+
+// one half of a binary splitting, for a thread of its own
+struct Splitting
+{
+  BigNumber::SeriesTerm term;
+  void * context;
+  int places;
+  long a, b, total;
+  int threads;
+  BigNumber P, Q, B, T;
+};
+
+// Binary splitting for the terms a to b-1 of a series (see seriesSum) where
+// every ratio p (n) / q (n) also has a factor of 10^-places.
+// The sum of those terms, divided by the product of the ratios up to term
+// a-1, is T / (B * Q * 10^(places * (b - a))), where P, Q and B are the
+// products of the p's, q's and b's.  Each term is a chance to stop (see
+// bc_poll), and total is the number of terms, for the progress reported.
+// With threads above one the halves are split between that many threads,
+// so term must then be safe to call from several at once; only this
+// thread's half can be stopped.
+// Must be called with a scale of zero (all integers).
+void BigNumber::splitSeries (SeriesTerm term, void * context, const int places,
+                             const long a, const long b, const long total,
+                             BigNumber & P, BigNumber & Q, BigNumber & B, BigNumber & T,
+                             const int threads)
+{
+  if (b - a == 1)
+    {
+    BigNumber A = 1;
+    P = 1;
+    Q = 1;
+    B = 1;
+    if (bc_poll (a, total))
+      {
+      T = 0;
+      return;
+      }
+    term (a, context, A, B, P, Q);
+    T = A * P;
+    return;
+    }
+
+  const long mid = a + (b - a) / 2;
+  BigNumber P2, Q2, B2, T2;
+  if (threads > 1 && b - a >= THREAD_SPLIT_TERMS)
+    {
+    Splitting left, right;
+    left.term = right.term = term;
+    left.context = right.context = context;
+    left.places = right.places = places;
+    left.total = right.total = total;
+    left.a = a;
+    left.b = right.a = mid;
+    right.b = b;
+    left.threads = threads / 2;
+    right.threads = threads - threads / 2;
+    // the left half stays in this thread, where it can be stopped
+    runPair (splitWork, &right, splitWork, &left);
+    P = left.P;
+    Q = left.Q;
+    B = left.B;
+    T = left.T;
+    P2 = right.P;
+    Q2 = right.Q;
+    B2 = right.B;
+    T2 = right.T;
+    }
+  else
+    {
+    splitSeries (term, context, places, a, mid, total, P, Q, B, T);
+    splitSeries (term, context, places, mid, b, total, P2, Q2, B2, T2);
+    }
+
+  T = shift (B2 * Q2 * T, places * (b - mid)) + B * P * T2;
+  P *= P2;
+  Q *= Q2;
+  B *= B2;
+} // end of BigNumber::splitSeries
+
+void BigNumber::splitWork (void * context)
+{
+  Splitting & s = * (Splitting *) context;
+  splitSeries (s.term, s.context, s.places, s.a, s.b, s.total, s.P, s.Q, s.B, s.T, s.threads);
+} // end of BigNumber::splitWork
+
+// The sum of the first count terms of a series, as above, truncated to scale
+// decimal places.  If count is zero terms are added in blocks of growing size
+// until a block no longer changes the sum at this scale.  threads is passed
+// to splitSeries.
+BigNumber BigNumber::sumSeries (SeriesTerm term, void * context, const int places,
+                                long count, const int scale, const int threads)
+{
+  const int oldScale = setScale (0);
+  BigNumber P, Q, B, T;
+
+  bc_poll_enter ();
+  if (count > 0)
+    splitSeries (term, context, places, 0, count, count, P, Q, B, T, threads);
+  else
+    {
+    count = 16;
+    splitSeries (term, context, places, 0, count, 0, P, Q, B, T, threads);
+    for (;;)
+      {
+      // a p of zero ends the series: no later term can change the sum
+      if (P.isZero ())
+        break;
+      BigNumber P2, Q2, B2, T2;
+      splitSeries (term, context, places, count, 2 * count, 0, P2, Q2, B2, T2, threads);
+      if (T2.isZero () || bc_poll_stopped ())
+        break;
+
+      // the sum of the block is P * T2 / (B2 * Q * Q2 * 10^(places * 2 * count)),
+      // which can be estimated from the sizes of the parts
+      const double size = log10Magnitude (P.num_) + log10Magnitude (T2.num_)
+                          - log10Magnitude (B2.num_)
+                          - log10Magnitude (Q.num_) - log10Magnitude (Q2.num_)
+                          - (double) places * 2 * count;
+
+      T = shift (B2 * Q2 * T, places * count) + B * P * T2;
+      P *= P2;
+      Q *= Q2;
+      B *= B2;
+      count *= 2;
+
+      if (size < - scale - GUARD_DIGITS)
+        break;
+      }
+    }
+
+  // the sum is T / (B * Q * 10^(places * count)), wanted to scale places
+  const long s = scale - places * count;
+  if (s >= 0)
+    T = shift (T, s) / (B * Q);
+  else
+    T = T / shift (B * Q, -s);
+  bc_poll_leave ();
+
+  setScale (oldScale);
+  return shift (T, -scale);
+} // end of BigNumber::sumSeries
+
+// the terms of a long series, passed through to a SeriesTermLong
+struct LongSeries
+{
+  BigNumber::SeriesTermLong term;
+  void * context;
+};
+
+// a SeriesTerm that calls a SeriesTermLong
+void BigNumber::longSeriesTerm (const long n, void * context,
+                                BigNumber & a, BigNumber & b, BigNumber & p, BigNumber & q)
+{
+  const LongSeries * series = (const LongSeries *) context;
+  long la = 1, lb = 1, lp = 1, lq = 1;
+  series->term (n, series->context, la, lb, lp, lq);
+  a = fromLong (la);
+  b = fromLong (lb);
+  p = fromLong (lp);
+  q = fromLong (lq);
+} // end of BigNumber::longSeriesTerm
+
+// Sum a series by binary splitting: the terms are combined as exact integer
+// fractions, which needs only one division at the end.
+BigNumber BigNumber::seriesSum (SeriesTerm term, void * context, const long count, int scale)
+{
+  if (scale < 0)
+    scale = scale_;
+  return sumSeries (term, context, 0, count, scale);
+} // end of BigNumber::seriesSum
+
+BigNumber BigNumber::seriesSum (SeriesTermLong term, void * context, const long count, int scale)
+{
+  LongSeries series = { term, context };
+  return seriesSum (longSeriesTerm, &series, count, scale);
+} // end of BigNumber::seriesSum
+
+// ----------------------------- EXP, SIN, COS -----------------------------
+
+// the series for exp, sin and cos (less their first term) as used by seriesChunk
+struct ChunkSeries
+{
+  const BigNumber * p;
+  int kind;
+};
+
+// term n (from 0) has the ratio p / seriesDenominator (kind, n + 1)
+void BigNumber::chunkTerm (const long n, void * context,
+                           BigNumber & /* a */, BigNumber & /* b */, BigNumber & p, BigNumber & q)
+{
+  const ChunkSeries * series = (const ChunkSeries *) context;
+  p = *series->p;
+  q = fromLong (seriesDenominator ((SeriesKind) series->kind, n + 1));
+} // end of BigNumber::chunkTerm
+
+// The sum of the series with term 0 being 1 and the ratio between terms n
+// and n-1 p / (seriesDenominator (kind, n) * 10^places), to scale decimal
+// places, where p / 10^places is less than one.  With p = m and places = e this is exp (m / 10^e); with
+// p = -m*m and places = 2e it is cos (m / 10^e) or sin (m / 10^e) * 10^e / m.
+BigNumber BigNumber::seriesChunk (const BigNumber & p, const int places, const SeriesKind kind,
+                                  const int scale, const int threads)
+{
+  // find how many terms we need: term n is 10^(n * size) / (q (1) * ... * q (n))
+  const double size = log10Magnitude (p.num_) - places;
+  double logTerm = 0;
+  int terms = 0;
+  do
+    {
+    terms++;
+    logTerm += size - log10 ((double) seriesDenominator (kind, terms));
+    } while (logTerm > - scale - 2);
+
+  ChunkSeries series = { &p, kind };
+  const BigNumber sum = sumSeries (chunkTerm, &series, places, terms, scale, threads);
+  const int oldScale = setScale (scale);
+  const BigNumber result = sum + BigNumber (1);
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::seriesChunk
+
+// exp (x) for x >= 0, with a relative error below 10^-scale
+BigNumber BigNumber::expPositive (const BigNumber & x, const int scale)
+{
+  // halve x until it is below 1/256, and square that many times at the end,
+  // which doubles the error each time
+  int halvings = 8;
+  for (long n = x; n != 0; n >>= 1)
+    halvings++;
+  const int workScale = scale + halvings * 3 / 10 + 2;
+
+  const int oldScale = setScale (workScale);
+  BigNumber r = x / BigNumber (2).pow (halvings);
+
+  // the "bit-burst" method: split r into pieces with 8, 8, 16, 32 ... digits
+  // and multiply together the exponentials of the pieces
+  BigNumber result = 1;
+  int start = 0;
+  int end = 8;
+  while (start < workScale)
+    {
+    if (end > workScale)
+      end = workScale;
+    const BigNumber m = piece (r, start, end);
+    if (!m.isZero ())
+      result *= seriesChunk (m, end, EXP_SERIES, workScale);
+    start = end;
+    end *= 2;
+    }
+
+  for (int i = 0; i < halvings; i++)
+    result *= result;
+
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::expPositive
+
+// e to the power of this number
+BigNumber BigNumber::exp () const
+{
+  const int scale = scale_;
+
+  if (isZero ())
+    return BigNumber (1);
+
+  // the result has about x * log10 (e) digits before the decimal point
+  // (a long holds x if it has no more than 9 digits before the point)
+  const double digits = num_->n_len > 9 ? 0 : (double) long (*this) * 0.4342944819;
+
+  if (!isNegative ())
+    {
+    // more digits than a scale can count?  (expPositive adds up to 20)
+    if (num_->n_len > 9 || (double) scale + digits + GUARD_DIGITS + 20 > INT_MAX)
+      {
+      bc_error (BC_ERROR_RESULT_TOO_LARGE);
+      return BigNumber (0);
+      }
+    const BigNumber result = expPositive (*this, scale + (int) digits + GUARD_DIGITS);
+    return truncate (result, scale);
+    }
+
+  // too small to show at this scale?
+  if (num_->n_len > 9 || digits < - scale - 1)
+    return BigNumber (0);
+
+  // take the reciprocal of exp (-x), which only needs enough digits
+  // to give the significant digits of the result
+  int precision = scale + (int) digits;
+  if (precision < 0)
+    precision = 0;
+  const BigNumber reciprocal = expPositive (BigNumber (0) - *this, precision + GUARD_DIGITS);
+  return BigNumber (1) / reciprocal;
+} // end of BigNumber::exp
+
+// ln (x) by Newton's method on exp, for 1 <= x <= 10
+// Each step y = y + 2 * (x - exp (y)) / (x + exp (y)) triples the number of
+// correct digits, so the working scale starts small and grows to scale.
+BigNumber BigNumber::lnNewton (const BigNumber & x, const int scale)
+{
+  const int oldScale = setScale (scale);
+
+  // first guess from floating point (at least 5 digits even on 8-bit AVRs)
+  BigNumber y = guess (log ((double) long (shift (x, 8)) / 1e8));
+
+  int precision = 5;
+  while (precision < scale)
+    {
+    precision *= 3;
+    if (precision > scale)
+      precision = scale;
+    const int workScale = precision + GUARD_DIGITS;
+    if (y.isNegative ())
+      y = 0;
+    const BigNumber ey = expPositive (y, workScale);
+    setScale (workScale);
+    y += BigNumber (2) * (x - ey) / (x + ey);
+    y = truncate (y, workScale);
+    }
+
+  setScale (oldScale);
+  return y;
+} // end of BigNumber::lnNewton
+
+// natural logarithm of this number
+BigNumber BigNumber::ln () const
+{
+  const int scale = scale_;
+
+  if (isNegative () || isZero ())
+    return BigNumber (0);
+
+  // write x as m * 10^d with 1 <= m < 10
+  const int d = decimalExponent (num_);
+
+  // d * ln (10) needs the extra digits of d
+  const int workScale = scale + GUARD_DIGITS + digitCount (d);
+
+  BigNumber result = lnNewton (shift (*this, -d), workScale);
+  if (d != 0)
+    {
+    const int oldScale = setScale (workScale);
+    result += BigNumber (d) * cached (ln10Cache, ln10Scale, workScale, ln10Newton);
+    setScale (oldScale);
+    }
+
+  return truncate (result, scale);
+} // end of BigNumber::ln
+
+// the series atan (1 / k) = 1 / k - 1 / (3 k^3) + 1 / (5 k^5) - ...
+// or if hyperbolic
+// atanh (1 / k) = 1 / k + 1 / (3 k^3) + 1 / (5 k^5) + ...
+struct AtanSeries
+{
+  int k;
+  bool hyperbolic;
+};
+
+void BigNumber::atanTerm (const long n, void * context,
+                          BigNumber & /* a */, BigNumber & b, BigNumber & p, BigNumber & q)
+{
+  const AtanSeries * series = (const AtanSeries *) context;
+  b = fromLong (2 * n + 1);
+  if (n == 0)
+    q = series->k;
+  else
+    {
+    q = BigNumber (series->k) * BigNumber (series->k);
+    if (!series->hyperbolic)
+      p = -1;
+    }
+} // end of BigNumber::atanTerm
+
+// atan (1 / k), or atanh (1 / k) if hyperbolic, for an integer k > 1
+BigNumber BigNumber::atanInverse (const int k, const bool hyperbolic, const int scale,
+                                  const int threads)
+{
+  // each term is k^2 times smaller than the one before
+  const int terms = (int) ((scale + 2) / (2 * log10 ((double) k))) + 1;
+
+  AtanSeries series = { k, hyperbolic };
+  return sumSeries (atanTerm, &series, 0, terms, scale, threads);
+} // end of BigNumber::atanInverse
+
+// sin and cos of x, where x is at most pi / 4 in size
+// x is halved 8 times, the series for the pieces of x are summed as for exp
+// and added up with the addition formulas, then the angle is doubled back.
+void BigNumber::sinCosReduced (const BigNumber & x, const int scale, BigNumber & s, BigNumber & c)
+{
+  // each doubling can double the errors
+  const int halvings = 8;
+  const int workScale = scale + halvings * 3 / 10 + 2;
+
+  const int oldScale = setScale (workScale);
+  const bool negative = x.isNegative ();
+  const BigNumber r = (negative ? BigNumber (0) - x : x) / BigNumber (1 << halvings);
+
+  s = 0;
+  c = 1;
+  int start = 0;
+  int end = 8;
+  while (start < workScale)
+    {
+    if (end > workScale)
+      end = workScale;
+    const BigNumber m = piece (r, start, end);
+    if (!m.isZero ())
+      {
+      setScale (0);
+      const BigNumber p = BigNumber (0) - m * m;
+      setScale (workScale);
+      const BigNumber ps = shift (m, -end) * seriesChunk (p, 2 * end, SIN_SERIES, workScale);
+      const BigNumber pc = seriesChunk (p, 2 * end, COS_SERIES, workScale);
+      const BigNumber t = s * pc + c * ps;
+      c = c * pc - s * ps;
+      s = t;
+      }
+    start = end;
+    end *= 2;
+    }
+
+  for (int i = 0; i < halvings; i++)
+    {
+    const BigNumber t = BigNumber (2) * s * c;
+    c = c * c - s * s;
+    s = t;
+    }
+
+  if (negative)
+    s = BigNumber (0) - s;
+  setScale (oldScale);
+} // end of BigNumber::sinCosReduced
+
+// sin and cos of any x, reduced by a multiple of pi / 2
+void BigNumber::sinCos (const BigNumber & x, const int scale, BigNumber & s, BigNumber & c)
+{
+  // the multiple of pi / 2 has as many digits as x, so pi needs that many more
+  const int digits = x.num_->n_len;
+  const int workScale = scale + GUARD_DIGITS;
+  const int oldScale = setScale (workScale + digits);
+  const BigNumber halfPi = pi (workScale + digits) / BigNumber (2);
+  const BigNumber quarterPi = halfPi / BigNumber (2);
+  BigNumber k = truncate (x / halfPi, 0);
+  BigNumber r = x - k * halfPi;
+  if (r > quarterPi)
+    {
+    r -= halfPi;
+    k += 1;
+    }
+  else if (r < BigNumber (0) - quarterPi)
+    {
+    r += halfPi;
+    k -= 1;
+    }
+
+  setScale (0);
+  int quadrant = long (k % BigNumber (4));
+  if (quadrant < 0)
+    quadrant += 4;
+  setScale (oldScale);
+
+  BigNumber s0, c0;
+  sinCosReduced (r, workScale, s0, c0);
+  switch (quadrant)
+    {
+    case 0: s = s0;                 c = c0;                 break;
+    case 1: s = c0;                 c = BigNumber (0) - s0; break;
+    case 2: s = BigNumber (0) - s0; c = BigNumber (0) - c0; break;
+    case 3: s = BigNumber (0) - c0; c = s0;                 break;
+    }
+} // end of BigNumber::sinCos
+
+// sine of this number
+BigNumber BigNumber::sin () const
+{
+  BigNumber s, c;
+  sinCos (*this, scale_, s, c);
+  return truncate (s, scale_);
+} // end of BigNumber::sin
+
+// cosine of this number
+BigNumber BigNumber::cos () const
+{
+  BigNumber s, c;
+  sinCos (*this, scale_, s, c);
+  return truncate (c, scale_);
+} // end of BigNumber::cos
+
+// tangent of this number
+BigNumber BigNumber::tan () const
+{
+  const int scale = scale_;
+
+  // near pi / 2 the cosine is small, and each leading zero of it costs two
+  // digits of the result, so get that many more
+  BigNumber s, c;
+  int extra = 0;
+  while (true)
+    {
+    sinCos (*this, scale + extra, s, c);
+    const int zeros = c.isZero () ? scale + extra + 1 : - decimalExponent (c.num_);
+    if (2 * zeros + 2 <= extra)
+      break;
+    extra = 2 * zeros + 2;
+    }
+
+  const int oldScale = setScale (scale + GUARD_DIGITS);
+  const BigNumber result = s / c;
+  setScale (oldScale);
+  return truncate (result, scale);
+} // end of BigNumber::tan
+
+// atan (x) to scale decimal places (plus or minus one in the last place)
+// For |x| <= 1 this uses Newton's method on tan: the correction
+// (x cos y - sin y) / (cos y + x sin y) is tan (atan (x) - y), so each step
+// triples the number of correct digits.
+BigNumber BigNumber::atanWork (const BigNumber & x, const int scale)
+{
+  if (x.isZero ())
+    return BigNumber (0);
+
+  const int workScale = scale + GUARD_DIGITS;
+  const int oldScale = setScale (workScale);
+
+  const bool negative = x.isNegative ();
+  BigNumber a = negative ? BigNumber (0) - x : x;
+  const bool invert = a > BigNumber (1);
+  if (invert)
+    a = BigNumber (1) / a;
+
+  // first guess from floating point (at least 5 digits even on 8-bit AVRs)
+  BigNumber y = guess (::atan ((double) long (shift (a, 8)) / 1e8));
+
+  int precision = 5;
+  while (precision < workScale)
+    {
+    precision *= 3;
+    if (precision > workScale)
+      precision = workScale;
+    const int stepScale = precision + GUARD_DIGITS;
+    BigNumber s, c;
+    sinCosReduced (y, stepScale, s, c);
+    setScale (stepScale);
+    y += (a * c - s) / (c + a * s);
+    y = truncate (y, stepScale);
+    }
+
+  setScale (workScale);
+  if (invert)
+    y = pi (workScale) / BigNumber (2) - y;
+  if (negative)
+    y = BigNumber (0) - y;
+
+  setScale (oldScale);
+  return y;
+} // end of BigNumber::atanWork
+
+// arc tangent of this number
+BigNumber BigNumber::atan () const
+{
+  return truncate (atanWork (*this, scale_), scale_);
+} // end of BigNumber::atan
+
+// angle of the point (x, y) from the x axis, from -pi to pi
+BigNumber BigNumber::atan2 (const BigNumber & y, const BigNumber & x)
+{
+  const int scale = scale_;
+  const int workScale = scale + GUARD_DIGITS;
+
+  if (x.isZero () && y.isZero ())
+    return BigNumber (0);
+
+  // the angle is negative below the x axis
+  BigNumber result;
+  const int oldScale = setScale (workScale);
+  if (x.isZero ())
+    {
+    result = pi (workScale) / BigNumber (2);
+    if (y.isNegative ())
+      result = BigNumber (0) - result;
+    }
+  else
+    {
+    result = atanWork (y / x, workScale);
+    if (x.isNegative ())
+      {
+      if (y.isNegative ())
+        result -= pi (workScale);
+      else
+        result += pi (workScale);
+      }
+    }
+  setScale (oldScale);
+
+  return truncate (result, scale);
+} // end of BigNumber::atan2
+
+// ------------------------------ CONSTANTS -------------------------------
+
+// Return a constant to scale decimal places (the current scale if scale is
+// negative), using the cached value if it has enough places, otherwise
+// working it out with compute and keeping that.
+BigNumber BigNumber::cached (bc_num & cache, int & cacheScale, int scale,
+                             BigNumber (* compute) (const int scale))
+{
+  if (scale < 0)
+    scale = scale_;
+
+  BigNumber value;
+  int valueScale = -1;
+  {
+    CACHE_LOCK;
+    if (cache != NULL && cacheScale >= scale)
+      {
+      bc_free_num (&value.num_);
+      value.num_ = bc_copy_num (cache);
+      valueScale = cacheScale;
+      }
+  }
+
+  // another thread may be working it out too; keep the more precise one
+  if (valueScale < 0)
+    {
+    value = compute (scale);
+    valueScale = scale;
+    CACHE_LOCK;
+    if ((cache == NULL || cacheScale < scale) && !bc_poll_stopped ())
+      {
+      bc_free_num (&cache);
+      cache = bc_copy_num (value.num_);
+      cacheScale = scale;
+      }
+    }
+
+  if (valueScale == scale)
+    return value;
+  return truncate (value, scale);
+} // end of BigNumber::cached
+
+// free the cached constants
+void BigNumber::freeConstants ()
+{
+  CACHE_LOCK;
+  bc_free_num (&piCache);
+  bc_free_num (&eCache);
+  bc_free_num (&ln2Cache);
+  bc_free_num (&sqrt2Cache);
+  bc_free_num (&ln10Cache);
+} // end of BigNumber::freeConstants
+
+// 1 / sqrt (n) by Newton's method: y = y + y * (1 - n * y * y) / 2
+// This only multiplies (and halves), doubling the correct digits each step.
+BigNumber BigNumber::inverseSqrt (const int n, const int scale)
+{
+  const int workScale = scale + GUARD_DIGITS;
+  const int oldScale = setScale (workScale);
+  const BigNumber half ("0.5");
+
+  BigNumber y = guess (1 / ::sqrt ((double) n));
+  int precision = 5;
+  while (precision < workScale)
+    {
+    precision *= 2;
+    if (precision > workScale)
+      precision = workScale;
+    setScale (precision + GUARD_DIGITS);
+    y += y * (BigNumber (1) - BigNumber (n) * y * y) * half;
+    }
+
+  setScale (oldScale);
+  return truncate (y, scale);
+} // end of BigNumber::inverseSqrt
+
+// the Chudnovsky series
+// 1 / pi = 12 / 640320^(3/2) * sum (-1)^n (6n)! (13591409 + 545140134 n) / ((3n)! (n!)^3 640320^(3n))
+void BigNumber::piTerm (const long n, void * /* context */,
+                        BigNumber & a, BigNumber & /* b */, BigNumber & p, BigNumber & q)
+{
+  const BigNumber N = fromLong (n);
+  a = BigNumber ("13591409") + BigNumber ("545140134") * N;
+  if (n > 0)
+    {
+    p = BigNumber (0) - fromLong (6 * n - 5) * fromLong (2 * n - 1) * fromLong (6 * n - 1);
+    q = N * N * N * BigNumber ("10939058860032000");  // 640320^3 / 24
+    }
+} // end of BigNumber::piTerm
+
+// pi by the Chudnovsky series, which gives 14 digits a term:
+// pi = 426880 * sqrt (10005) / sum = 426880 * 10005 / sqrt (10005) / sum
+BigNumber BigNumber::piChudnovsky (const int scale)
+{
+  const int workScale = scale + GUARD_DIGITS;
+  const long terms = workScale / 14 + 2;
+  const BigNumber sum = sumSeries (piTerm, NULL, 0, terms, workScale, threadCount (0, terms));
+
+  const int oldScale = setScale (workScale);
+  const BigNumber result = BigNumber ("4270934400") * inverseSqrt (10005, workScale) / sum;
+  setScale (oldScale);
+  return truncate (result, scale);
+} // end of BigNumber::piChudnovsky
+
+// e as the sum of 1 / n!
+BigNumber BigNumber::eSeries (const int scale)
+{
+  return truncate (seriesChunk (BigNumber (1), 0, EXP_SERIES, scale + GUARD_DIGITS,
+                               threadCount (0, scale)), scale);
+} // end of BigNumber::eSeries
+
+// ln (2) = 18 atanh (1/26) - 2 atanh (1/4801) + 8 atanh (1/8749)
+BigNumber BigNumber::ln2Series (const int scale)
+{
+  const int workScale = scale + GUARD_DIGITS;
+  const int threads = threadCount (0, workScale);
+  const BigNumber a = atanInverse (26, true, workScale, threads);
+  const BigNumber b = atanInverse (4801, true, workScale, threads);
+  const BigNumber c = atanInverse (8749, true, workScale, threads);
+
+  const int oldScale = setScale (workScale);
+  const BigNumber result = BigNumber (18) * a - BigNumber (2) * b + BigNumber (8) * c;
+  setScale (oldScale);
+  return truncate (result, scale);
+} // end of BigNumber::ln2Series
+
+// sqrt (2) = 2 / sqrt (2)
+BigNumber BigNumber::sqrt2Newton (const int scale)
+{
+  const BigNumber y = inverseSqrt (2, scale + 1);
+  const int oldScale = setScale (scale + 1);
+  const BigNumber result = BigNumber (2) * y;
+  setScale (oldScale);
+  return truncate (result, scale);
+} // end of BigNumber::sqrt2Newton
+
+// ln (10), for ln
+BigNumber BigNumber::ln10Newton (const int scale)
+{
+  return truncate (lnNewton (BigNumber (10), scale + GUARD_DIGITS), scale);
+} // end of BigNumber::ln10Newton
+
+BigNumber BigNumber::pi (const int scale)
+{
+  return cached (piCache, piScale, scale, piChudnovsky);
+} // end of BigNumber::pi
+
+BigNumber BigNumber::e (const int scale)
+{
+  return cached (eCache, eScale, scale, eSeries);
+} // end of BigNumber::e
+
+BigNumber BigNumber::ln2 (const int scale)
+{
+  return cached (ln2Cache, ln2Scale, scale, ln2Series);
+} // end of BigNumber::ln2
+
+BigNumber BigNumber::sqrt2 (const int scale)
+{
+  return cached (sqrt2Cache, sqrt2Scale, scale, sqrt2Newton);
+} // end of BigNumber::sqrt2
@@ -0,0 +1,337 @@
+//
+//  BigNumberRadix.cpp
+//
+//  Conversion of BigNumbers to and from other bases, and to and from bytes.
+//  Released into the public domain.
+//
+//  Only the integer part of a number is converted.  The conversion is
+//  divide and conquer: a number of 2h digits in the base is split into two
+//  halves of h digits with one multiply (going in) or one divide (going
+//  out) by base^h, where h is a power of two times the number of digits that
+//  fit in a long.  Those powers of the base are worked out once for each
+//  conversion, as are their reciprocals, so that the large divides are done
+//  as multiplies.
+
+#include "BigNumber.h"
+
+extern "C"
+{
+ #include "bcconfig.h"
+}
+
+#include <stdlib.h>
+
+// powers with more decimal digits than this are divided by multiplying by
+// their reciprocals; below it long division is quicker
+static const int RECIPROCAL_DIGITS = 200;
+
+// the powers of the base used by a conversion
+struct BigNumber::RadixPowers
+{
+  int base;
+  size_t leaf;              // digits in the base that fit in a long
+  int levels;               // powers worked out so far
+  BigNumber power [32];     // base ^ (leaf * 2^i)
+  BigNumber inverse [32];   // the reciprocal of power [i], see reciprocal
+
+  RadixPowers (const int b) : base (b), leaf (0), levels (0)
+  {
+    for (long n = 1; n <= 2147483647L / base; n *= base)
+      leaf++;
+  }
+};
+
+// base ^ (leaf * 2^level)
+const BigNumber & BigNumber::radixPower (RadixPowers & powers, const int level)
+{
+  while (powers.levels <= level)
+    {
+    const int i = powers.levels++;
+    if (i == 0)
+      {
+      long n = 1;
+      for (size_t j = 0; j < powers.leaf; j++)
+        n *= powers.base;
+      powers.power [0] = fromLong (n);
+      }
+    else
+      powers.power [i] = powers.power [i - 1] * powers.power [i - 1];
+    }
+  return powers.power [level];
+} // end of BigNumber::radixPower
+
+// About 10^(2d) / n for an integer n of d digits, to within 1, by Newton's
+// method for 1/x, x = n / 10^d: y = y + y * (1 - x * y), which only multiplies
+// and doubles the correct digits each time.
+BigNumber BigNumber::reciprocal (const BigNumber & n)
+{
+  const int d = n.num_->n_len;
+  const int oldScale = setScale (0);
+  const BigNumber x = shift (n, -d);
+
+  BigNumber y = guess (1 / ((double) long (shift (x, 8)) / 1e8));
+  int precision = 5;
+  while (precision < d + 2)
+    {
+    precision *= 2;
+    if (precision > d + 2)
+      precision = d + 2;
+    setScale (precision + 4);
+    y += y * (BigNumber (1) - truncate (x, precision + 4) * y);
+    }
+
+  setScale (0);
+  const BigNumber result = truncate (shift (y, d), 0);
+  setScale (oldScale);
+  return result;
+} // end of BigNumber::reciprocal
+
+// Put the count digits in the base of the integer n (which must be less than
+// base^count) into digits, most significant first.
+// Must be called with a scale of zero.
+void BigNumber::radixOut (const BigNumber & n, unsigned char * digits, const size_t count,
+                          RadixPowers & powers)
+{
+  if (count <= powers.leaf)
+    {
+    long value = n;
+    for (size_t i = count; i-- > 0; )
+      {
+      digits [i] = (unsigned char) (value % powers.base);
+      value /= powers.base;
+      }
+    return;
+    }
+
+  // split off the low h digits, where h < count <= 2h
+  int level = 0;
+  size_t h = powers.leaf;
+  while (2 * h < count)
+    {
+    h *= 2;
+    level++;
+    }
+  const BigNumber & power = radixPower (powers, level);
+
+  BigNumber q, r;
+  if (power.num_->n_len <= RECIPROCAL_DIGITS)
+    bc_divmod (n.num_, power.num_, &q.num_, &r.num_, 0);
+  else
+    {
+    // n < power^2, so n * inverse / 10^(2d) is at most 2 below the quotient
+    if (powers.inverse [level].isZero ())
+      powers.inverse [level] = reciprocal (power);
+    const int d = power.num_->n_len;
+    q = truncate (shift (n * powers.inverse [level], -2 * d), 0);
+    r = n - q * power;
+    while (r.isNegative ())
+      {
+      --q;
+      r += power;
+      }
+    while (r >= power)
+      {
+      ++q;
+      r -= power;
+      }
+    }
+
+  radixOut (q, digits, count - h, powers);
+  radixOut (r, digits + count - h, h, powers);
+} // end of BigNumber::radixOut
+
+// The integer with the count digits in the base, most significant first.
+// Must be called with a scale of zero.
+BigNumber BigNumber::radixIn (const unsigned char * digits, const size_t count,
+                              RadixPowers & powers)
+{
+  if (count <= powers.leaf)
+    {
+    long value = 0;
+    for (size_t i = 0; i < count; i++)
+      value = value * powers.base + digits [i];
+    return fromLong (value);
+    }
+
+  int level = 0;
+  size_t h = powers.leaf;
+  while (2 * h < count)
+    {
+    h *= 2;
+    level++;
+    }
+
+  return radixIn (digits, count - h, powers) * radixPower (powers, level)
+         + radixIn (digits + count - h, h, powers);
+} // end of BigNumber::radixIn
+
+// The digits in the base of the size of the integer part of the number,
+// most significant first, with no leading zeros (but at least one digit).
+// The digits are put in a buffer which the caller MUST FREE after use.
+size_t BigNumber::radixDigits (const int base, unsigned char * & digits) const
+{
+  const int oldScale = setScale (0);
+  BigNumber n = truncate (*this, 0);
+  if (n.isNegative ())
+    n = BigNumber (0) - n;
+
+  // enough digits for the number, from its number of decimal digits
+  size_t count = (size_t) (n.num_->n_len * (log (10.0) / log ((double) base))) + 2;
+  digits = (unsigned char *) malloc (count);
+  if (digits == NULL)
+    bc_out_of_memory ();
+
+  RadixPowers powers (base);
+  radixOut (n, digits, count, powers);
+  setScale (oldScale);
+
+  size_t zeros = 0;
+  while (zeros < count - 1 && digits [zeros] == 0)
+    zeros++;
+  memmove (digits, digits + zeros, count - zeros);
+  return count - zeros;
+} // end of BigNumber::radixDigits
+
+// the number written in the base (2 to 36), with an optional leading '-'
+// Conversion stops at the first character which is not a digit in the base.
+// Any other base gives zero.
+BigNumber BigNumber::fromBase (const char * s, const int base)
+{
+  if (base < 2 || base > 36)
+    return BigNumber (0);
+
+  bool negative = false;
+  if (*s == '-' || *s == '+')
+    negative = *s++ == '-';
+
+  const size_t length = strlen (s);
+  unsigned char * digits = (unsigned char *) malloc (length + 1);
+  if (digits == NULL)
+    bc_out_of_memory ();
+
+  size_t count = 0;
+  for ( ; *s; s++)
+    {
+    int digit;
+    if (*s >= '0' && *s <= '9')
+      digit = *s - '0';
+    else if (*s >= 'a' && *s <= 'z')
+      digit = *s - 'a' + 10;
+    else if (*s >= 'A' && *s <= 'Z')
+      digit = *s - 'A' + 10;
+    else
+      break;
+    if (digit >= base)
+      break;
+    digits [count++] = (unsigned char) digit;
+    }
+
+  const int oldScale = setScale (0);
+  RadixPowers powers (base);
+  BigNumber result = radixIn (digits, count, powers);
+  if (negative && !result.isZero ())
+    result = BigNumber (0) - result;
+  setScale (oldScale);
+
+  free (digits);
+  return result;
+} // end of BigNumber::fromBase
+
+// the integer part of the number written in the base (2 to 36), or NULL
+// for any other base
+// MUST FREE IT after use!
+char * BigNumber::toBase (const int base) const
+{
+  if (base < 2 || base > 36)
+    return NULL;
+
+  unsigned char * digits;
+  const size_t count = radixDigits (base, digits);
+  const bool negative = isNegative () && (count > 1 || digits [0] != 0);
+
+  char * s = (char *) malloc (count + 2);
+  if (s == NULL)
+    bc_out_of_memory ();
+  char * p = s;
+  if (negative)
+    *p++ = '-';
+  for (size_t i = 0; i < count; i++)
+    *p++ = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ" [digits [i]];
+  *p = 0;
+
+  free (digits);
+  return s;
+} // end of BigNumber::toBase
+
+// hexadecimal, with an optional "0x" after any sign
+BigNumber BigNumber::fromHex (const char * s)
+{
+  const char * p = s;
+  if (*p == '-' || *p == '+')
+    p++;
+  if (p [0] != '0' || (p [1] != 'x' && p [1] != 'X'))
+    return fromBase (s, 16);
+
+  BigNumber result = fromBase (p + 2, 16);
+  if (*s == '-' && !result.isZero ())
+    {
+    const int oldScale = setScale (0);
+    result = BigNumber (0) - result;
+    setScale (oldScale);
+    }
+  return result;
+} // end of BigNumber::fromHex
+
+// MUST FREE IT after use!
+char * BigNumber::toHex () const
+{
+  return toBase (16);
+} // end of BigNumber::toHex
+
+// the unsigned integer in the bytes
+BigNumber BigNumber::fromBytes (const uint8_t * bytes, const size_t length, const bool bigEndian)
+{
+  const uint8_t * digits = bytes;
+  uint8_t * reversed = NULL;
+  if (!bigEndian)
+    {
+    reversed = (uint8_t *) malloc (length + 1);
+    if (reversed == NULL)
+      bc_out_of_memory ();
+    for (size_t i = 0; i < length; i++)
+      reversed [i] = bytes [length - 1 - i];
+    digits = reversed;
+    }
+
+  const int oldScale = setScale (0);
+  RadixPowers powers (256);
+  const BigNumber result = radixIn (digits, length, powers);
+  setScale (oldScale);
+
+  free (reversed);
+  return result;
+} // end of BigNumber::fromBytes
+
+// Put the size of the integer part of the number into length bytes, padded
+// with zeros.  Returns the number of bytes needed: if that is more than
+// length nothing is written, so call with a length of zero to find the size.
+size_t BigNumber::toBytes (uint8_t * bytes, const size_t length, const bool bigEndian) const
+{
+  unsigned char * digits;
+  size_t count = radixDigits (256, digits);
+  if (count == 1 && digits [0] == 0)
+    count = 0;
+
+  if (count <= length && bytes != NULL)
+    {
+    memset (bytes, 0, length);
+    for (size_t i = 0; i < count; i++)
+      if (bigEndian)
+        bytes [length - count + i] = digits [i];
+      else
+        bytes [count - 1 - i] = digits [i];
+    }
+
+  free (digits);
+  return count;
+} // end of BigNumber::toBytes
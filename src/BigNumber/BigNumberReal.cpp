@@ -0,0 +1,414 @@
+//
+//  BigNumberReal.cpp
+//
+//  Exact real numbers, worked out lazily to the places asked for.
+//  Released into the public domain.
+//
+//  A BigReal is a node of an expression: a number, a constant, or an
+//  operation on other BigReals.  Nothing is worked out until value () is
+//  asked for.  Then each node is asked for an approximation to p places,
+//  that is within 10^-p of its true value, and asks its operands for the
+//  places they need for that (more for the divisor of a small quotient,
+//  fewer for the parts of a sum which are then rounded), so the digits lost
+//  to cancellation are made up for where they are lost.  Each node keeps
+//  its best approximation, so asking for the same or fewer places again,
+//  or for a node shared by several others, is quick.
+//
+//  The bounds used, for approximations a' and b' of a and b:
+//    a + b:   |a - a'| + |b - b'|
+//    a * b:   |a| |b - b'| + |b'| |a - a'|
+//    a / b:   |a - a'| / |b'| + |a'| |b - b'| / (|b| |b'|)
+//    sqrt a:  sqrt |a - a'|
+//    exp a:   e^(|a| + 1) |a - a'|
+//    ln a:    |a - a'| / min (a, a')
+//    sin a, cos a, atan a:  |a - a'|
+//    a^n:     n (2 |a|)^(n - 1) |a - a'|
+//  where |a| comes from a rough approximation of a, and a lower bound of
+//  |b| (or a) from approximations to more places until one is clearly not
+//  zero.  An operand which is still indistinguishable from zero at
+//  ZERO_PLACES places (or four times the places asked for, if more) is
+//  taken to be zero: dividing by it, or taking its logarithm, gives zero.
+//
+//  Working out a value recurses down the expression, and each level asks
+//  for a place or two more than the one above, so very deep expressions
+//  (such as adding to the same BigReal thousands of times) need a lot of
+//  stack and many places; BigNumber::sum of the parts is better for those.
+
+#include "BigNumber.h"
+
+#include <limits.h>
+
+// the places to which a divisor must look like zero to be taken as zero
+static const int ZERO_PLACES = 1000;
+
+enum RealOp { REAL_NUMBER, REAL_PI, REAL_E, REAL_NEGATE, REAL_ADD, REAL_SUBTRACT,
+              REAL_MULTIPLY, REAL_DIVIDE, REAL_SQRT, REAL_POWER, REAL_EXP, REAL_LN,
+              REAL_SIN, REAL_COS, REAL_ATAN };
+
+struct BigReal::Node
+{
+  int refs;
+  RealOp op;
+  Node * a;         // the operands
+  Node * b;
+  long n;           // the exponent of REAL_POWER
+  BigNumber value;  // the number, or the best approximation so far
+  int places;       // the places value is good to (-1 for none yet)
+
+  Node (const RealOp o, Node * x, Node * y) : refs (1), op (o), a (x), b (y), n (0), places (-1)
+  {
+    if (a != NULL)
+      a->refs++;
+    if (b != NULL)
+      b->refs++;
+  }
+};
+
+// ---------------------------- NODE HANDLING -----------------------------
+
+BigReal::BigReal (Node * node) : node_ (node)
+{
+} // end of BigReal::BigReal
+
+BigReal::BigReal () : node_ (new Node (REAL_NUMBER, NULL, NULL))
+{
+} // end of BigReal::BigReal
+
+BigReal::BigReal (const BigNumber & n) : node_ (new Node (REAL_NUMBER, NULL, NULL))
+{
+  node_->value = n;
+} // end of BigReal::BigReal
+
+BigReal::BigReal (const int n) : node_ (new Node (REAL_NUMBER, NULL, NULL))
+{
+  node_->value = n;
+} // end of BigReal::BigReal
+
+// all the digits of s, whatever the current scale
+BigReal::BigReal (const char * s) : node_ (new Node (REAL_NUMBER, NULL, NULL))
+{
+  const int oldScale = BigNumber::setScale (strlen (s));
+  node_->value = BigNumber (s);
+  BigNumber::setScale (oldScale);
+} // end of BigReal::BigReal
+
+BigReal::BigReal (const BigReal & rhs) : node_ (rhs.node_)
+{
+  node_->refs++;
+} // end of BigReal::BigReal
+
+BigReal & BigReal::operator= (const BigReal & rhs)
+{
+  rhs.node_->refs++;
+  release (node_);
+  node_ = rhs.node_;
+  return *this;
+} // end of BigReal::operator=
+
+BigReal::~BigReal ()
+{
+  release (node_);
+} // end of BigReal::~BigReal
+
+// drop a reference to a node, and to its operands if it is no longer used
+// (without recursing, as expressions can be long chains)
+void BigReal::release (Node * node)
+{
+  while (node != NULL && --node->refs == 0)
+    {
+    Node * a = node->a;
+    Node * b = node->b;
+    delete node;
+    release (b);
+    node = a;
+    }
+} // end of BigReal::release
+
+BigReal BigReal::make (const int op, const BigReal * x, const BigReal * y)
+{
+  return BigReal (new Node ((RealOp) op, x ? x->node_ : NULL, y ? y->node_ : NULL));
+} // end of BigReal::make
+
+// ------------------------------ OPERATIONS ------------------------------
+
+BigReal BigReal::operator- () const
+{
+  return make (REAL_NEGATE, this, NULL);
+} // end of BigReal::operator-
+
+BigReal BigReal::operator+ (const BigReal & rhs) const
+{
+  return make (REAL_ADD, this, &rhs);
+} // end of BigReal::operator+
+
+BigReal BigReal::operator- (const BigReal & rhs) const
+{
+  return make (REAL_SUBTRACT, this, &rhs);
+} // end of BigReal::operator-
+
+BigReal BigReal::operator* (const BigReal & rhs) const
+{
+  return make (REAL_MULTIPLY, this, &rhs);
+} // end of BigReal::operator*
+
+BigReal BigReal::operator/ (const BigReal & rhs) const
+{
+  return make (REAL_DIVIDE, this, &rhs);
+} // end of BigReal::operator/
+
+BigReal BigReal::sqrt () const
+{
+  return make (REAL_SQRT, this, NULL);
+} // end of BigReal::sqrt
+
+// the number to the power n (which may be negative)
+BigReal BigReal::pow (const long n) const
+{
+  BigReal result = make (REAL_POWER, this, NULL);
+  result.node_->n = n < 0 ? -n : n;
+  if (n < 0)
+    return BigReal (1) / result;
+  return result;
+} // end of BigReal::pow
+
+BigReal BigReal::exp () const
+{
+  return make (REAL_EXP, this, NULL);
+} // end of BigReal::exp
+
+BigReal BigReal::ln () const
+{
+  return make (REAL_LN, this, NULL);
+} // end of BigReal::ln
+
+BigReal BigReal::sin () const
+{
+  return make (REAL_SIN, this, NULL);
+} // end of BigReal::sin
+
+BigReal BigReal::cos () const
+{
+  return make (REAL_COS, this, NULL);
+} // end of BigReal::cos
+
+BigReal BigReal::atan () const
+{
+  return make (REAL_ATAN, this, NULL);
+} // end of BigReal::atan
+
+BigReal BigReal::pi ()
+{
+  return make (REAL_PI, NULL, NULL);
+} // end of BigReal::pi
+
+BigReal BigReal::e ()
+{
+  return make (REAL_E, NULL, NULL);
+} // end of BigReal::e
+
+// The value truncated to places decimal places, which is less than two
+// units in the last place from the exact value.
+BigNumber BigReal::value (const int places) const
+{
+  const int p = places > 0 ? places : 0;
+  const BigNumber v = approximate (node_, p + 1);
+  return BigNumber::truncate (v, p);
+} // end of BigReal::value
+
+// ----------------------------- APPROXIMATION ----------------------------
+
+static BigNumber absolute (const BigNumber & x)
+{
+  return x.isNegative () ? BigNumber (0) - x : x;
+} // end of absolute
+
+// m such that |x| <= 10^m (at least 0)
+int BigReal::magnitude (Node * node)
+{
+  const int oldScale = BigNumber::setScale (0);
+  const BigNumber bound = BigNumber::truncate (absolute (approximate (node, 0)) + BigNumber (1), 0);
+  BigNumber::setScale (oldScale);
+  return bound.num_->n_len;
+} // end of BigReal::magnitude
+
+// Find n such that |x| >= 10^-n, and the sign of x.  Returns false if x
+// cannot be told from zero.
+bool BigReal::lowerBound (Node * node, const int places, int & n, bool & negative)
+{
+  const int limit = places * 4 > ZERO_PLACES ? places * 4 : ZERO_PLACES;
+  const int oldScale = BigNumber::setScale (0);
+  bool found = false;
+  for (int k = 1; !found; k *= 2)
+    {
+    const BigNumber v = approximate (node, k);
+    const BigNumber unit = BigNumber::shift (BigNumber (1), -k);
+    const BigNumber d = absolute (v) - unit;  // |x| >= d
+    if (d > unit)
+      {
+      n = - BigNumber::decimalExponent (d.num_);
+      negative = v.isNegative ();
+      found = true;
+      }
+    else if (k >= limit)
+      break;
+    }
+  BigNumber::setScale (oldScale);
+  return found;
+} // end of BigReal::lowerBound
+
+// the product, exact
+static BigNumber exactProduct (const BigNumber & x, const BigNumber & y)
+{
+  const int oldScale = BigNumber::setScale (INT_MAX / 2);
+  const BigNumber result = x * y;
+  BigNumber::setScale (oldScale);
+  return result;
+} // end of exactProduct
+
+// An approximation of the node within 10^-places, kept for next time.
+BigNumber BigReal::approximate (Node * node, const int places)
+{
+  if (node->op == REAL_NUMBER)
+    {
+    if (node->value.num_->n_scale <= places)
+      return node->value;
+    return BigNumber::truncate (node->value, places);
+    }
+  if (node->places >= places)
+    return node->value;
+
+  const int p = places;
+  const int oldScale = BigNumber::setScale (0);
+  BigNumber result;
+  switch (node->op)
+    {
+    case REAL_PI:
+      result = BigNumber::pi (p + 1);
+      break;
+
+    case REAL_E:
+      result = BigNumber::e (p + 1);
+      break;
+
+    case REAL_NEGATE:
+      result = BigNumber (0) - approximate (node->a, p);
+      break;
+
+    // each within 10^-(p+1)
+    case REAL_ADD:
+      result = approximate (node->a, p + 1) + approximate (node->b, p + 1);
+      break;
+
+    case REAL_SUBTRACT:
+      result = approximate (node->a, p + 1) - approximate (node->b, p + 1);
+      break;
+
+    // |a| |b - b'| <= 10^-(p+1) and |b'| |a - a'| <= 2 * 10^-(p+2)
+    case REAL_MULTIPLY:
+      {
+      const int ma = magnitude (node->a);
+      const int mb = magnitude (node->b);
+      result = exactProduct (approximate (node->a, p + mb + 2), approximate (node->b, p + ma + 1));
+      result = BigNumber::truncate (result, p + 2);
+      break;
+      }
+
+    // with |b| >= 10^-nb, |b'| >= 0.9 * 10^-nb, so the two parts of the
+    // error are at most 0.11 and 0.22 of 10^-p, then 0.1 for the division
+    case REAL_DIVIDE:
+      {
+      int nb;
+      bool negative;
+      if (!lowerBound (node->b, p, nb, negative))
+        break;  // dividing by zero
+      const int ma = magnitude (node->a);
+      const int pa = p + nb + 1;
+      const int pb = p + ma + 2 * nb + 1;
+      const BigNumber a = approximate (node->a, pa > 0 ? pa : 0);
+      const BigNumber b = approximate (node->b, pb > 0 ? pb : 0);
+      BigNumber::setScale (p + 1);
+      result = a / b;
+      break;
+      }
+
+    // sqrt of within 10^-(2p+2) is within 10^-(p+1)
+    case REAL_SQRT:
+      {
+      const BigNumber a = approximate (node->a, 2 * p + 2);
+      if (a.isNegative ())
+        break;
+      BigNumber::setScale (p + 1);
+      result = a.sqrt ();
+      break;
+      }
+
+    // the derivative is at most n (2 * 10^ma)^(n-1)
+    case REAL_POWER:
+      {
+      const long n = node->n;
+      if (n == 0)
+        {
+        result = 1;
+        break;
+        }
+      const double growth = log10 ((double) n) + (n - 1) * (magnitude (node->a) + 0.302);
+      if (growth > INT_MAX / 4)
+        break;
+      const int pa = p + 1 + (int) ceil (growth);
+      const BigNumber a = approximate (node->a, pa);
+      BigNumber::setScale (a.num_->n_scale * n < INT_MAX / 2 ? (int) (a.num_->n_scale * n) : INT_MAX / 2);
+      result = BigNumber::truncate (a.pow (BigNumber::fromLong (n)), p + 1);
+      break;
+      }
+
+    // e^a grows by at most 10^growth, growth = (|a| + 1) log10 e
+    case REAL_EXP:
+      {
+      const BigNumber a0 = approximate (node->a, 0);
+      const double growth = ceil (((double) absolute (a0).toDouble () + 2) * 0.4342944819);
+      if (growth > INT_MAX / 4)
+        break;
+      const BigNumber a = approximate (node->a, p + (int) growth + 1);
+      BigNumber::setScale (p + 1);
+      result = a.exp ();
+      break;
+      }
+
+    // with a >= 10^-na, |ln a - ln a'| <= |a - a'| * 10^na / 0.9
+    case REAL_LN:
+      {
+      int na;
+      bool negative;
+      if (!lowerBound (node->a, p, na, negative) || negative)
+        break;  // not positive
+      const int pa = p + na + 2;
+      const BigNumber a = approximate (node->a, pa > 0 ? pa : 0);
+      BigNumber::setScale (p + 1);
+      result = a.ln ();
+      break;
+      }
+
+    case REAL_SIN:
+    case REAL_COS:
+    case REAL_ATAN:
+      {
+      const BigNumber a = approximate (node->a, p + 1);
+      BigNumber::setScale (p + 1);
+      if (node->op == REAL_SIN)
+        result = a.sin ();
+      else if (node->op == REAL_COS)
+        result = a.cos ();
+      else
+        result = a.atan ();
+      break;
+      }
+
+    default:
+      break;
+    }
+  BigNumber::setScale (oldScale);
+
+  node->value = result;
+  node->places = p;
+  return result;
+} // end of BigReal::approximate
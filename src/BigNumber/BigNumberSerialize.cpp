@@ -0,0 +1,289 @@
+//
+//  BigNumberSerialize.cpp
+//
+//  Binary forms of BigNumbers: a compact one for single numbers, and a
+//  table of numbers which can be read in place (eg. memory-mapped).
+//  Released into the public domain.
+//
+//  Single number (version 1):
+//    1 byte   version
+//    1 byte   flags: bit 0 set if negative
+//    varint   n_len     (7 bits a byte, least significant first, top bit
+//    varint   n_scale    set if more bytes follow)
+//    the n_len + n_scale digits, two to a byte, first digit in the high half
+//
+//  Table (version 1), all integers 4 bytes, least significant byte first:
+//    'B' 'N' 'T' version
+//    count
+//    count entries of: offset of the digits, n_len, n_scale, sign (1 if negative)
+//    the digits, one to a byte (0 to 9) as they are held in memory, so the
+//    numbers can use them where they are
+
+#include "BigNumber.h"
+
+extern "C"
+{
+ #include "bcconfig.h"
+}
+
+#include <limits.h>
+#include <stdlib.h>
+
+static const uint8_t SERIAL_VERSION = 1;
+static const uint8_t TABLE_VERSION = 1;
+static const size_t TABLE_HEADER = 8;
+static const size_t TABLE_ENTRY = 16;
+
+// the bytes needed for n as a varint
+static size_t varintSize (unsigned long n)
+{
+  size_t size = 1;
+  while (n >= 0x80)
+    {
+    n >>= 7;
+    size++;
+    }
+  return size;
+} // end of varintSize
+
+static uint8_t * putVarint (uint8_t * p, unsigned long n)
+{
+  while (n >= 0x80)
+    {
+    *p++ = (uint8_t) (n | 0x80);
+    n >>= 7;
+    }
+  *p++ = (uint8_t) n;
+  return p;
+} // end of putVarint
+
+// read a varint of at most INT_MAX, returning NULL if it is not valid
+static const uint8_t * getVarint (const uint8_t * p, const uint8_t * end, int & n)
+{
+  unsigned long value = 0;
+  for (int shift = 0; p < end && shift < 32; shift += 7)
+    {
+    value |= (unsigned long) (*p & 0x7F) << shift;
+    if ((*p++ & 0x80) == 0)
+      {
+      if (value > INT_MAX)
+        return NULL;
+      n = (int) value;
+      return p;
+      }
+    }
+  return NULL;
+} // end of getVarint
+
+static void put32 (uint8_t * p, const unsigned long n)
+{
+  p [0] = (uint8_t) n;
+  p [1] = (uint8_t) (n >> 8);
+  p [2] = (uint8_t) (n >> 16);
+  p [3] = (uint8_t) (n >> 24);
+} // end of put32
+
+static unsigned long get32 (const uint8_t * p)
+{
+  return p [0] | ((unsigned long) p [1] << 8) | ((unsigned long) p [2] << 16) | ((unsigned long) p [3] << 24);
+} // end of get32
+
+// -------------------------------- SINGLE --------------------------------
+
+// the bytes serialize needs
+size_t BigNumber::serializedSize () const
+{
+  const int digits = num_->n_len + num_->n_scale;
+  return 2 + varintSize (num_->n_len) + varintSize (num_->n_scale) + (digits + 1) / 2;
+} // end of BigNumber::serializedSize
+
+// Put the number in its compact binary form into buf, which has room for
+// cap bytes.  Returns the size, and writes nothing if that is more than cap.
+size_t BigNumber::serialize (uint8_t * buf, const size_t cap) const
+{
+  const size_t size = serializedSize ();
+  if (buf == NULL || size > cap)
+    return size;
+
+  uint8_t * p = buf;
+  *p++ = SERIAL_VERSION;
+  *p++ = num_->n_sign == MINUS ? 1 : 0;
+  p = putVarint (p, num_->n_len);
+  p = putVarint (p, num_->n_scale);
+
+  const char * digit = num_->n_value;
+  const int digits = num_->n_len + num_->n_scale;
+  for (int i = 0; i < digits; i += 2)
+    *p++ = (uint8_t) ((digit [i] << 4) | (i + 1 < digits ? digit [i + 1] : 0));
+
+  return size;
+} // end of BigNumber::serialize
+
+// Read a number in the form serialize writes from the length bytes at buf.
+// Returns the number of bytes used, or zero (and result zero) if they do
+// not hold a valid number.
+size_t BigNumber::deserialize (const uint8_t * buf, const size_t length, BigNumber & result)
+{
+  const uint8_t * end = buf + length;
+  int len = 0;
+  int scale = 0;
+  const uint8_t * p = buf;
+
+  result = 0;
+  if (length < 2 || p [0] != SERIAL_VERSION || (p [1] & ~1) != 0)
+    return 0;
+  p += 2;
+  p = getVarint (p, end, len);
+  if (p != NULL)
+    p = getVarint (p, end, scale);
+  if (p == NULL || len < 1 || len > INT_MAX - scale)
+    return 0;
+
+  const int digits = len + scale;
+  if ((size_t) (end - p) < (size_t) digits / 2 + (digits & 1))
+    return 0;
+
+  bc_num num = bc_new_num (len, scale);
+  char * digit = num->n_value;
+  for (int i = 0; i < digits; i++)
+    {
+    const uint8_t value = (i & 1) ? (p [i / 2] & 0x0F) : (p [i / 2] >> 4);
+    if (value > 9)
+      {
+      bc_free_num (&num);
+      return 0;
+      }
+    *digit++ = (char) value;
+    }
+  p += (digits + 1) / 2;
+  if (len > 1 && num->n_value [0] == 0)
+    {
+    bc_free_num (&num);  // leading zeros, which the operations do not expect
+    return 0;
+    }
+  num->n_sign = (buf [1] & 1) && !bc_is_zero (num) ? MINUS : PLUS;
+
+  bc_free_num (&result.num_);
+  result.num_ = num;
+  return p - buf;
+} // end of BigNumber::deserialize
+
+// --------------------------------- VIEWS --------------------------------
+
+// a number using length + scale digits (0 to 9) held elsewhere
+BigNumberView::BigNumberView (const char * digits, const int length, const int scale, const bool negative)
+{
+  set (digits, length, scale, negative);
+} // end of BigNumberView::BigNumberView
+
+// A new number for the digits: just the descriptor, on the heap like any
+// other, so that numbers copied from the view keep it (unchanged) after
+// the view is changed or gone.  With no n_ptr, freeing it leaves the
+// digits alone.
+void BigNumberView::set (const char * digits, const int length, const int scale, const bool negative)
+{
+  bc_num num = (bc_num) malloc (sizeof (bc_struct));
+  if (num == NULL)
+    bc_out_of_memory ();
+  num->n_sign = negative ? MINUS : PLUS;
+  num->n_len = length;
+  num->n_scale = scale;
+  num->n_refs = 1;
+  num->n_next = NULL;
+  num->n_ptr = NULL;
+  num->n_value = (char *) digits;
+  if (bc_is_zero (num))
+    num->n_sign = PLUS;  // as for any other zero
+  bc_free_num (&number_.num_);
+  number_.num_ = num;
+} // end of BigNumberView::set
+
+// --------------------------------- TABLES -------------------------------
+
+// the bytes needed for a table of count numbers
+size_t BigNumberTable::size (const BigNumber * numbers, const size_t count)
+{
+  size_t size = TABLE_HEADER + count * TABLE_ENTRY;
+  for (size_t i = 0; i < count; i++)
+    size += numbers [i].num_->n_len + numbers [i].num_->n_scale;
+  return size;
+} // end of BigNumberTable::size
+
+// Put a table of count numbers into buf, which has room for cap bytes.
+// Returns the size, and writes nothing if that is more than cap.
+size_t BigNumberTable::write (const BigNumber * numbers, const size_t count, uint8_t * buf, const size_t cap)
+{
+  const size_t total = size (numbers, count);
+  if (buf == NULL || total > cap)
+    return total;
+
+  buf [0] = 'B';
+  buf [1] = 'N';
+  buf [2] = 'T';
+  buf [3] = TABLE_VERSION;
+  put32 (buf + 4, count);
+
+  size_t offset = TABLE_HEADER + count * TABLE_ENTRY;
+  for (size_t i = 0; i < count; i++)
+    {
+    const bc_num num = numbers [i].num_;
+    const size_t digits = num->n_len + num->n_scale;
+    uint8_t * entry = buf + TABLE_HEADER + i * TABLE_ENTRY;
+    put32 (entry, offset);
+    put32 (entry + 4, num->n_len);
+    put32 (entry + 8, num->n_scale);
+    put32 (entry + 12, num->n_sign == MINUS ? 1 : 0);
+    memcpy (buf + offset, num->n_value, digits);
+    offset += digits;
+    }
+
+  return total;
+} // end of BigNumberTable::write
+
+// Use the table in the length bytes at data, which must stay there
+// (unchanged) while the table and any numbers from it are in use.
+// Returns false if it is not a valid table (including any digit which is
+// not 0 to 9, or a number with leading zeros).
+bool BigNumberTable::open (const uint8_t * data, const size_t length)
+{
+  data_ = NULL;
+  count_ = 0;
+  if (length < TABLE_HEADER || data [0] != 'B' || data [1] != 'N' || data [2] != 'T'
+      || data [3] != TABLE_VERSION)
+    return false;
+
+  const unsigned long count = get32 (data + 4);
+  if (count > (length - TABLE_HEADER) / TABLE_ENTRY)
+    return false;
+
+  for (unsigned long i = 0; i < count; i++)
+    {
+    const uint8_t * entry = data + TABLE_HEADER + i * TABLE_ENTRY;
+    const unsigned long offset = get32 (entry);
+    const unsigned long len = get32 (entry + 4);
+    const unsigned long scale = get32 (entry + 8);
+    if (len < 1 || len > INT_MAX || scale > (unsigned long) INT_MAX - len
+        || get32 (entry + 12) > 1 || offset > length || len + scale > length - offset)
+      return false;
+
+    // digits 0 to 9, with no leading zeros
+    const uint8_t * digit = data + offset;
+    if (len > 1 && digit [0] == 0)
+      return false;
+    for (unsigned long j = 0; j < len + scale; j++)
+      if (digit [j] > 9)
+        return false;
+    }
+
+  data_ = data;
+  count_ = count;
+  return true;
+} // end of BigNumberTable::open
+
+// number i of the table, using the digits where they are
+BigNumberView BigNumberTable::operator[] (const size_t i) const
+{
+  const uint8_t * entry = data_ + TABLE_HEADER + i * TABLE_ENTRY;
+  return BigNumberView ((const char *) data_ + get32 (entry), (int) get32 (entry + 4),
+                        (int) get32 (entry + 8), get32 (entry + 12) != 0);
+} // end of BigNumberTable::operator[]
@@ -0,0 +1,297 @@
+//
+//  BigNumberTask.cpp
+//
+//  Long computations in threads of their own, which can be watched,
+//  waited for and cancelled.
+//  Released into the public domain.
+//
+//  The loops of the long operations in number.c (division, square roots,
+//  powers) and the series sums call bc_poll as they go.  A task's thread
+//  has a poll handler which records the progress, passes it on to the
+//  task's progress handler, and tells the loops to give up once the task is
+//  cancelled, so that a cancelled computation soon stops using its core.
+//  Without BIGNUMBER_THREADS (see number.h) start does the computation
+//  itself, and only the progress handler can stop it.
+
+#include "BigNumber.h"
+
+#if BIGNUMBER_THREADS
+ #include <atomic>
+ #include <chrono>
+ #include <condition_variable>
+ #include <mutex>
+ #include <thread>
+typedef std::atomic<bool> TaskFlag;
+typedef std::atomic<long> TaskCount;
+#else
+typedef bool TaskFlag;
+typedef long TaskCount;
+#endif
+
+struct BigNumberTask::State
+{
+  Function function;
+  void * context;
+  BigNumber a, b, c;  // the operands of the operations
+  int scale;          // and the places of the constants
+
+  BigNumber::ProgressHandler handler;  // used by the task's thread
+  void * handlerContext;
+  BigNumber::ProgressHandler nextHandler;  // for the next start
+  void * nextHandlerContext;
+  TaskFlag cancel;
+  TaskCount done;
+  TaskCount total;
+
+  // these are only changed with the lock held (with threads)
+  bool started;
+  bool finished;
+  bool stopped;
+  BigNumber result;
+
+#if BIGNUMBER_THREADS
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable finishing;
+#endif
+
+  State () : function (NULL), context (NULL), scale (-1), handler (NULL), handlerContext (NULL),
+             nextHandler (NULL), nextHandlerContext (NULL), cancel (false), done (0), total (0),
+             started (false), finished (false), stopped (false)
+  {
+  }
+
+  // the poll handler of the task's thread
+  static int poll (void * context, long done, long total)
+  {
+    State & state = * (State *) context;
+    if (total > 0)
+      {
+      state.done = done;
+      state.total = total;
+      }
+    if (state.handler != NULL && state.handler (state.handlerContext, done, total))
+      state.cancel = true;
+    return state.cancel;
+  }
+
+  // use the progress handler last set, for the computation about to start
+  void takeHandler ()
+  {
+#if BIGNUMBER_THREADS
+    std::lock_guard <std::mutex> lock (mutex);
+#endif
+    handler = nextHandler;
+    handlerContext = nextHandlerContext;
+  }
+
+  void run ()
+  {
+    bc_set_poll_handler (poll, this);
+    const BigNumber value = function (context);
+    const bool wasStopped = BigNumber::stopped ();
+    bc_set_poll_handler (NULL, NULL);
+
+#if BIGNUMBER_THREADS
+    std::lock_guard <std::mutex> lock (mutex);
+#endif
+    result = wasStopped ? BigNumber (0) : value;
+    stopped = wasStopped;
+    finished = true;
+#if BIGNUMBER_THREADS
+    finishing.notify_all ();
+#endif
+  }
+
+  static BigNumber sqrt (void * context)
+  {
+    return ((State *) context)->a.sqrt ();
+  }
+
+  static BigNumber pow (void * context)
+  {
+    const State & state = * (const State *) context;
+    return state.a.pow (state.b);
+  }
+
+  static BigNumber powMod (void * context)
+  {
+    const State & state = * (const State *) context;
+    return state.a.powMod (state.b, state.c);
+  }
+
+  static BigNumber divide (void * context)
+  {
+    const State & state = * (const State *) context;
+    return state.a / state.b;
+  }
+
+  static BigNumber pi (void * context)
+  {
+    return BigNumber::pi (((State *) context)->scale);
+  }
+
+  static BigNumber e (void * context)
+  {
+    return BigNumber::e (((State *) context)->scale);
+  }
+};
+
+BigNumberTask::BigNumberTask () : state_ (new State)
+{
+} // end of BigNumberTask::BigNumberTask
+
+BigNumberTask::~BigNumberTask ()
+{
+  cancel ();
+#if BIGNUMBER_THREADS
+  if (state_->thread.joinable ())
+    state_->thread.join ();
+#endif
+  delete state_;
+} // end of BigNumberTask::~BigNumberTask
+
+// Set the progress handler, for computations started after this.  It is
+// kept aside until then, as a running computation's thread reads its own.
+void BigNumberTask::setProgressHandler (BigNumber::ProgressHandler handler, void * context)
+{
+#if BIGNUMBER_THREADS
+  std::lock_guard <std::mutex> lock (state_->mutex);
+#endif
+  state_->nextHandler = handler;
+  state_->nextHandlerContext = context;
+} // end of BigNumberTask::setProgressHandler
+
+bool BigNumberTask::start (Function function, void * context)
+{
+  State & state = *state_;
+  if (state.started && !finished ())
+    return false;
+
+#if BIGNUMBER_THREADS
+  if (state.thread.joinable ())
+    state.thread.join ();
+#endif
+  state.function = function;
+  state.context = context;
+  state.takeHandler ();
+  state.cancel = false;
+  state.done = 0;
+  state.total = 0;
+  state.started = true;
+  state.finished = false;
+  state.stopped = false;
+  state.result = 0;
+
+#if BIGNUMBER_THREADS
+  const int scale = BigNumber::scale_;
+  state.thread = std::thread ([&state, scale] { BigNumber::setScale (scale); state.run (); });
+#else
+  state.run ();
+#endif
+  return true;
+} // end of BigNumberTask::start
+
+bool BigNumberTask::sqrt (const BigNumber & x)
+{
+  if (state_->started && !finished ())
+    return false;
+  state_->a = x;
+  return start (State::sqrt, state_);
+} // end of BigNumberTask::sqrt
+
+bool BigNumberTask::pow (const BigNumber & x, const BigNumber & power)
+{
+  if (state_->started && !finished ())
+    return false;
+  state_->a = x;
+  state_->b = power;
+  return start (State::pow, state_);
+} // end of BigNumberTask::pow
+
+bool BigNumberTask::powMod (const BigNumber & x, const BigNumber & power, const BigNumber & modulus)
+{
+  if (state_->started && !finished ())
+    return false;
+  state_->a = x;
+  state_->b = power;
+  state_->c = modulus;
+  return start (State::powMod, state_);
+} // end of BigNumberTask::powMod
+
+bool BigNumberTask::divide (const BigNumber & x, const BigNumber & y)
+{
+  if (state_->started && !finished ())
+    return false;
+  state_->a = x;
+  state_->b = y;
+  return start (State::divide, state_);
+} // end of BigNumberTask::divide
+
+bool BigNumberTask::pi (const int scale)
+{
+  if (state_->started && !finished ())
+    return false;
+  state_->scale = scale;
+  return start (State::pi, state_);
+} // end of BigNumberTask::pi
+
+bool BigNumberTask::e (const int scale)
+{
+  if (state_->started && !finished ())
+    return false;
+  state_->scale = scale;
+  return start (State::e, state_);
+} // end of BigNumberTask::e
+
+// ask the computation to stop (it does so at its next poll)
+void BigNumberTask::cancel ()
+{
+  state_->cancel = true;
+} // end of BigNumberTask::cancel
+
+bool BigNumberTask::finished () const
+{
+#if BIGNUMBER_THREADS
+  std::lock_guard <std::mutex> lock (state_->mutex);
+#endif
+  return state_->finished;
+} // end of BigNumberTask::finished
+
+bool BigNumberTask::cancelled () const
+{
+#if BIGNUMBER_THREADS
+  std::lock_guard <std::mutex> lock (state_->mutex);
+#endif
+  return state_->finished && state_->stopped;
+} // end of BigNumberTask::cancelled
+
+bool BigNumberTask::wait (const unsigned long ms)
+{
+  State & state = *state_;
+#if BIGNUMBER_THREADS
+  std::unique_lock <std::mutex> lock (state.mutex);
+  if (state.started)
+    state.finishing.wait_for (lock, std::chrono::milliseconds (ms), [&state] { return state.finished; });
+#else
+  (void) ms;
+#endif
+  return state.finished;
+} // end of BigNumberTask::wait
+
+BigNumber BigNumberTask::result ()
+{
+  State & state = *state_;
+#if BIGNUMBER_THREADS
+  std::unique_lock <std::mutex> lock (state.mutex);
+  if (state.started)
+    state.finishing.wait (lock, [&state] { return state.finished; });
+#endif
+  return state.result;
+} // end of BigNumberTask::result
+
+void BigNumberTask::progress (long & done, long & total) const
+{
+  done = state_->done;
+  total = state_->total;
+} // end of BigNumberTask::progress
@@ -0,0 +1,617 @@
+//
+//  BigUInt.h
+//
+//  Fixed size integers, kept in the object itself (no heap).
+//  Released into the public domain.
+//
+//  BigUInt<Bits> is an unsigned integer of Bits bits (a multiple of 32),
+//  and BigInt<Bits> a signed (two's complement) one.  Like the built in
+//  integer types, they wrap around on overflow: the results are modulo
+//  2^Bits.  As the size is known when compiling, the loops all have a fixed
+//  number of turns, which the compiler can unroll (at -O2 or above) and
+//  specialise for the size.  With C++14 or later the operations are
+//  constexpr, so constants can be worked out when compiling.
+//
+//  They convert to and from BigNumber (through toBytes / fromBytes, so
+//  that part uses the heap), and can be written as decimal into a buffer
+//  the caller supplies.  As with BigNumber, errors (eg. dividing by zero)
+//  give zero.
+
+#ifndef _BigUInt_h
+#define _BigUInt_h
+
+#include <stdint.h>
+#include "BigNumber.h"
+
+#if __cplusplus >= 201402L
+ #define BIGUINT_CONSTEXPR constexpr
+#else
+ #define BIGUINT_CONSTEXPR inline
+#endif
+
+template <unsigned Bits> class BigUInt
+{
+  static_assert (Bits > 0 && Bits % 32 == 0, "BigUInt: Bits must be a multiple of 32");
+
+  template <unsigned> friend class BigUInt;
+  template <unsigned> friend class BigInt;
+
+public:
+  enum { LIMBS = Bits / 32 };
+
+private:
+  // the 32 bit pieces, least significant first
+  uint32_t limb_ [LIMBS];
+
+public:
+  // constructors
+  BIGUINT_CONSTEXPR BigUInt () : limb_ () { }
+  BIGUINT_CONSTEXPR BigUInt (const uint64_t n);
+  // another size, cut down or padded with zeros
+  template <unsigned OtherBits>
+  BIGUINT_CONSTEXPR explicit BigUInt (const BigUInt<OtherBits> & n);
+  // the integer part of n, modulo 2^Bits
+  explicit BigUInt (const BigNumber & n);
+  BigNumber toBigNumber () const;
+
+  // the decimal digits into buf (see BigNumber::toChars): returns the
+  // length, and only writes them if that is less than cap
+  size_t toChars (char * buf, const size_t cap) const;
+
+  BIGUINT_CONSTEXPR bool isZero () const;
+  BIGUINT_CONSTEXPR bool bit (const unsigned n) const;
+  BIGUINT_CONSTEXPR unsigned bitLength () const;  // zero for zero
+  BIGUINT_CONSTEXPR uint32_t toUInt32 () const { return limb_ [0]; }
+
+  // arithmetic, modulo 2^Bits
+  BIGUINT_CONSTEXPR BigUInt & operator+= (const BigUInt & n);
+  BIGUINT_CONSTEXPR BigUInt & operator-= (const BigUInt & n);
+  BIGUINT_CONSTEXPR BigUInt & operator*= (const BigUInt & n) { return *this = *this * n; }
+  BIGUINT_CONSTEXPR BigUInt & operator/= (const BigUInt & n) { return *this = *this / n; }
+  BIGUINT_CONSTEXPR BigUInt & operator%= (const BigUInt & n) { return *this = *this % n; }
+  BIGUINT_CONSTEXPR BigUInt operator+ (const BigUInt & n) const { BigUInt temp = *this; temp += n; return temp; }
+  BIGUINT_CONSTEXPR BigUInt operator- (const BigUInt & n) const { BigUInt temp = *this; temp -= n; return temp; }
+  BIGUINT_CONSTEXPR BigUInt operator* (const BigUInt & n) const;
+  BIGUINT_CONSTEXPR BigUInt operator/ (const BigUInt & n) const { BigUInt q, r; divMod (*this, n, q, r); return q; }
+  BIGUINT_CONSTEXPR BigUInt operator% (const BigUInt & n) const { BigUInt q, r; divMod (*this, n, q, r); return r; }
+  BIGUINT_CONSTEXPR BigUInt operator- () const { return BigUInt () - *this; }
+  BIGUINT_CONSTEXPR BigUInt & operator++ () { return *this += 1; }
+  BIGUINT_CONSTEXPR BigUInt & operator-- () { return *this -= 1; }
+
+  // the full product, of twice the size
+  BIGUINT_CONSTEXPR BigUInt<Bits * 2> mulWide (const BigUInt & n) const;
+  // quotient and remainder of u / v
+  static BIGUINT_CONSTEXPR void divMod (const BigUInt & u, const BigUInt & v, BigUInt & q, BigUInt & r);
+  // (this * n) mod m, and this^power mod m, without overflowing
+  BIGUINT_CONSTEXPR BigUInt mulMod (const BigUInt & n, const BigUInt & m) const;
+  BIGUINT_CONSTEXPR BigUInt powMod (const BigUInt & power, const BigUInt & m) const;
+
+  // bitwise operations
+  BIGUINT_CONSTEXPR BigUInt operator~ () const;
+  BIGUINT_CONSTEXPR BigUInt & operator&= (const BigUInt & n);
+  BIGUINT_CONSTEXPR BigUInt & operator|= (const BigUInt & n);
+  BIGUINT_CONSTEXPR BigUInt & operator^= (const BigUInt & n);
+  BIGUINT_CONSTEXPR BigUInt operator& (const BigUInt & n) const { BigUInt temp = *this; temp &= n; return temp; }
+  BIGUINT_CONSTEXPR BigUInt operator| (const BigUInt & n) const { BigUInt temp = *this; temp |= n; return temp; }
+  BIGUINT_CONSTEXPR BigUInt operator^ (const BigUInt & n) const { BigUInt temp = *this; temp ^= n; return temp; }
+  BIGUINT_CONSTEXPR BigUInt operator<< (const unsigned n) const;
+  BIGUINT_CONSTEXPR BigUInt operator>> (const unsigned n) const;
+  BIGUINT_CONSTEXPR BigUInt & operator<<= (const unsigned n) { return *this = *this << n; }
+  BIGUINT_CONSTEXPR BigUInt & operator>>= (const unsigned n) { return *this = *this >> n; }
+
+  // comparisons
+  static BIGUINT_CONSTEXPR int compare (const BigUInt & a, const BigUInt & b);
+  BIGUINT_CONSTEXPR bool operator== (const BigUInt & rhs) const { return compare (*this, rhs) == 0; }
+  BIGUINT_CONSTEXPR bool operator!= (const BigUInt & rhs) const { return compare (*this, rhs) != 0; }
+  BIGUINT_CONSTEXPR bool operator<  (const BigUInt & rhs) const { return compare (*this, rhs) < 0; }
+  BIGUINT_CONSTEXPR bool operator<= (const BigUInt & rhs) const { return compare (*this, rhs) <= 0; }
+  BIGUINT_CONSTEXPR bool operator>  (const BigUInt & rhs) const { return compare (*this, rhs) > 0; }
+  BIGUINT_CONSTEXPR bool operator>= (const BigUInt & rhs) const { return compare (*this, rhs) >= 0; }
+
+private:
+  static BIGUINT_CONSTEXPR unsigned significantLimbs (const uint32_t * limbs, const unsigned count);
+  static BIGUINT_CONSTEXPR uint32_t divideLimb (const BigUInt & u, const uint32_t v, BigUInt & q);
+};  // end of class BigUInt
+
+// A signed integer of Bits bits, in two's complement: the same bits as a
+// BigUInt, which does the work.  Division rounds towards zero, and the
+// remainder has the sign of the dividend, as for int.
+template <unsigned Bits> class BigInt
+{
+  BigUInt<Bits> bits_;
+
+public:
+  // constructors
+  BIGUINT_CONSTEXPR BigInt () { }
+  BIGUINT_CONSTEXPR BigInt (const int64_t n);
+  BIGUINT_CONSTEXPR explicit BigInt (const BigUInt<Bits> & bits) : bits_ (bits) { }
+  // the integer part of n, modulo 2^Bits
+  explicit BigInt (const BigNumber & n);
+  BigNumber toBigNumber () const;
+  size_t toChars (char * buf, const size_t cap) const;
+
+  BIGUINT_CONSTEXPR bool isNegative () const { return bits_.bit (Bits - 1); }
+  BIGUINT_CONSTEXPR bool isZero () const { return bits_.isZero (); }
+  BIGUINT_CONSTEXPR BigUInt<Bits> magnitude () const { return isNegative () ? - bits_ : bits_; }
+
+  // arithmetic, modulo 2^Bits
+  BIGUINT_CONSTEXPR BigInt operator- () const { return BigInt (- bits_); }
+  BIGUINT_CONSTEXPR BigInt operator+ (const BigInt & n) const { return BigInt (bits_ + n.bits_); }
+  BIGUINT_CONSTEXPR BigInt operator- (const BigInt & n) const { return BigInt (bits_ - n.bits_); }
+  BIGUINT_CONSTEXPR BigInt operator* (const BigInt & n) const { return BigInt (bits_ * n.bits_); }
+  BIGUINT_CONSTEXPR BigInt operator/ (const BigInt & n) const;
+  BIGUINT_CONSTEXPR BigInt operator% (const BigInt & n) const;
+  BIGUINT_CONSTEXPR BigInt & operator+= (const BigInt & n) { bits_ += n.bits_; return *this; }
+  BIGUINT_CONSTEXPR BigInt & operator-= (const BigInt & n) { bits_ -= n.bits_; return *this; }
+  BIGUINT_CONSTEXPR BigInt & operator*= (const BigInt & n) { return *this = *this * n; }
+  BIGUINT_CONSTEXPR BigInt & operator/= (const BigInt & n) { return *this = *this / n; }
+  BIGUINT_CONSTEXPR BigInt & operator%= (const BigInt & n) { return *this = *this % n; }
+  BIGUINT_CONSTEXPR BigInt & operator++ () { ++bits_; return *this; }
+  BIGUINT_CONSTEXPR BigInt & operator-- () { --bits_; return *this; }
+
+  // bitwise operations (>> copies the sign bit down)
+  BIGUINT_CONSTEXPR BigInt operator~ () const { return BigInt (~ bits_); }
+  BIGUINT_CONSTEXPR BigInt operator& (const BigInt & n) const { return BigInt (bits_ & n.bits_); }
+  BIGUINT_CONSTEXPR BigInt operator| (const BigInt & n) const { return BigInt (bits_ | n.bits_); }
+  BIGUINT_CONSTEXPR BigInt operator^ (const BigInt & n) const { return BigInt (bits_ ^ n.bits_); }
+  BIGUINT_CONSTEXPR BigInt operator<< (const unsigned n) const { return BigInt (bits_ << n); }
+  BIGUINT_CONSTEXPR BigInt operator>> (const unsigned n) const;
+
+  // comparisons
+  static BIGUINT_CONSTEXPR int compare (const BigInt & a, const BigInt & b);
+  BIGUINT_CONSTEXPR bool operator== (const BigInt & rhs) const { return bits_ == rhs.bits_; }
+  BIGUINT_CONSTEXPR bool operator!= (const BigInt & rhs) const { return bits_ != rhs.bits_; }
+  BIGUINT_CONSTEXPR bool operator<  (const BigInt & rhs) const { return compare (*this, rhs) < 0; }
+  BIGUINT_CONSTEXPR bool operator<= (const BigInt & rhs) const { return compare (*this, rhs) <= 0; }
+  BIGUINT_CONSTEXPR bool operator>  (const BigInt & rhs) const { return compare (*this, rhs) > 0; }
+  BIGUINT_CONSTEXPR bool operator>= (const BigInt & rhs) const { return compare (*this, rhs) >= 0; }
+};  // end of class BigInt
+
+// ------------------------------- BigUInt --------------------------------
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits>::BigUInt (const uint64_t n) : limb_ ()
+{
+  limb_ [0] = (uint32_t) n;
+  if (LIMBS > 1)
+    limb_ [LIMBS > 1 ? 1 : 0] = (uint32_t) (n >> 32);
+} // end of BigUInt::BigUInt
+
+template <unsigned Bits> template <unsigned OtherBits>
+BIGUINT_CONSTEXPR BigUInt<Bits>::BigUInt (const BigUInt<OtherBits> & n) : limb_ ()
+{
+  for (unsigned i = 0; i < LIMBS && i < BigUInt<OtherBits>::LIMBS; i++)
+    limb_ [i] = n.limb_ [i];
+} // end of BigUInt::BigUInt
+
+template <unsigned Bits>
+BigUInt<Bits>::BigUInt (const BigNumber & n) : limb_ ()
+{
+  uint8_t bytes [Bits / 8];
+  if (n.toBytes (bytes, sizeof bytes, false) > sizeof bytes)
+    {
+    // too big: keep the bottom Bits bits
+    const int oldScale = BigNumber::setScale (0);
+    const BigNumber size = BigNumber (2).pow (BigNumber (Bits));
+    const BigNumber bottom = (n.isNegative () ? BigNumber (0) - n : n) % size;
+    bottom.toBytes (bytes, sizeof bytes, false);
+    BigNumber::setScale (oldScale);
+    }
+  for (unsigned i = 0; i < sizeof bytes; i++)
+    limb_ [i / 4] |= (uint32_t) bytes [i] << (8 * (i % 4));
+  if (n.isNegative ())
+    *this = - *this;
+} // end of BigUInt::BigUInt
+
+template <unsigned Bits>
+BigNumber BigUInt<Bits>::toBigNumber () const
+{
+  uint8_t bytes [Bits / 8];
+  for (unsigned i = 0; i < sizeof bytes; i++)
+    bytes [i] = (uint8_t) (limb_ [i / 4] >> (8 * (i % 4)));
+  return BigNumber::fromBytes (bytes, sizeof bytes, false);
+} // end of BigUInt::toBigNumber
+
+// nine digits at a time, from the bottom, into a buffer big enough for any
+// value, then copied to the front of buf
+template <unsigned Bits>
+size_t BigUInt<Bits>::toChars (char * buf, const size_t cap) const
+{
+  char digits [Bits * 30103UL / 100000 + 2];  // log10 (2) * Bits, rounded up
+  char * p = digits + sizeof digits;
+  BigUInt n = *this;
+  do
+    {
+    uint32_t chunk = divideLimb (n, 1000000000UL, n);
+    const bool last = n.isZero ();
+    for (int i = 0; i < 9; i++)
+      {
+      *--p = '0' + chunk % 10;
+      chunk /= 10;
+      if (last && chunk == 0)
+        break;
+      }
+    } while (!n.isZero ());
+
+  const size_t length = digits + sizeof digits - p;
+  if (length < cap && buf != NULL)
+    {
+    memcpy (buf, p, length);
+    buf [length] = 0;
+    }
+  return length;
+} // end of BigUInt::toChars
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR bool BigUInt<Bits>::isZero () const
+{
+  for (unsigned i = 0; i < LIMBS; i++)
+    if (limb_ [i] != 0)
+      return false;
+  return true;
+} // end of BigUInt::isZero
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR bool BigUInt<Bits>::bit (const unsigned n) const
+{
+  return n < Bits && ((limb_ [n / 32] >> (n % 32)) & 1) != 0;
+} // end of BigUInt::bit
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR unsigned BigUInt<Bits>::bitLength () const
+{
+  const unsigned limbs = significantLimbs (limb_, LIMBS);
+  if (limbs == 0)
+    return 0;
+  unsigned length = (limbs - 1) * 32;
+  for (uint32_t top = limb_ [limbs - 1]; top != 0; top >>= 1)
+    length++;
+  return length;
+} // end of BigUInt::bitLength
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> & BigUInt<Bits>::operator+= (const BigUInt & n)
+{
+  uint64_t carry = 0;
+  for (unsigned i = 0; i < LIMBS; i++)
+    {
+    carry += (uint64_t) limb_ [i] + n.limb_ [i];
+    limb_ [i] = (uint32_t) carry;
+    carry >>= 32;
+    }
+  return *this;
+} // end of BigUInt::operator+=
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> & BigUInt<Bits>::operator-= (const BigUInt & n)
+{
+  uint32_t borrow = 0;
+  for (unsigned i = 0; i < LIMBS; i++)
+    {
+    const uint64_t difference = (uint64_t) limb_ [i] - n.limb_ [i] - borrow;
+    limb_ [i] = (uint32_t) difference;
+    borrow = (uint32_t) (difference >> 63);
+    }
+  return *this;
+} // end of BigUInt::operator-=
+
+// schoolbook, leaving out the products which only affect the bits above
+// Bits
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigUInt<Bits>::operator* (const BigUInt & n) const
+{
+  BigUInt result;
+  for (unsigned i = 0; i < LIMBS; i++)
+    {
+    if (limb_ [i] == 0)
+      continue;
+    uint64_t carry = 0;
+    for (unsigned j = 0; i + j < LIMBS; j++)
+      {
+      carry += (uint64_t) limb_ [i] * n.limb_ [j] + result.limb_ [i + j];
+      result.limb_ [i + j] = (uint32_t) carry;
+      carry >>= 32;
+      }
+    }
+  return result;
+} // end of BigUInt::operator*
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits * 2> BigUInt<Bits>::mulWide (const BigUInt & n) const
+{
+  BigUInt<Bits * 2> result;
+  for (unsigned i = 0; i < LIMBS; i++)
+    {
+    if (limb_ [i] == 0)
+      continue;
+    uint64_t carry = 0;
+    for (unsigned j = 0; j < LIMBS; j++)
+      {
+      carry += (uint64_t) limb_ [i] * n.limb_ [j] + result.limb_ [i + j];
+      result.limb_ [i + j] = (uint32_t) carry;
+      carry >>= 32;
+      }
+    result.limb_ [i + LIMBS] = (uint32_t) carry;
+    }
+  return result;
+} // end of BigUInt::mulWide
+
+// the number of limbs up to and including the top non-zero one
+template <unsigned Bits>
+BIGUINT_CONSTEXPR unsigned BigUInt<Bits>::significantLimbs (const uint32_t * limbs, unsigned count)
+{
+  while (count > 0 && limbs [count - 1] == 0)
+    count--;
+  return count;
+} // end of BigUInt::significantLimbs
+
+// q = u / v for a single limb v (not zero), returning the remainder
+template <unsigned Bits>
+BIGUINT_CONSTEXPR uint32_t BigUInt<Bits>::divideLimb (const BigUInt & u, const uint32_t v, BigUInt & q)
+{
+  uint64_t remainder = 0;
+  for (unsigned i = LIMBS; i-- > 0; )
+    {
+    remainder = (remainder << 32) | u.limb_ [i];
+    q.limb_ [i] = (uint32_t) (remainder / v);
+    remainder %= v;
+    }
+  return (uint32_t) remainder;
+} // end of BigUInt::divideLimb
+
+// Long division, a limb at a time (Knuth's algorithm D): the divisor is
+// shifted so its top bit is set, which keeps each estimate of a quotient
+// limb from the top two limbs at most two too big.
+template <unsigned Bits>
+BIGUINT_CONSTEXPR void BigUInt<Bits>::divMod (const BigUInt & u, const BigUInt & v,
+                                              BigUInt & q, BigUInt & r)
+{
+  const unsigned n = significantLimbs (v.limb_, LIMBS);
+  const unsigned m = significantLimbs (u.limb_, LIMBS);
+  if (n == 0)
+    {
+    q = r = BigUInt ();  // dividing by zero
+    return;
+    }
+  if (m < n)
+    {
+    r = u;
+    q = BigUInt ();
+    return;
+    }
+  if (n == 1)
+    {
+    r = BigUInt (divideLimb (u, v.limb_ [0], q));
+    return;
+    }
+
+  unsigned shift = 0;
+  for (uint32_t top = v.limb_ [n - 1]; (top & 0x80000000UL) == 0; top <<= 1)
+    shift++;
+  uint32_t vn [LIMBS] = { };
+  uint32_t un [LIMBS + 1] = { };
+  for (unsigned i = n - 1; i > 0; i--)
+    vn [i] = (v.limb_ [i] << shift) | (shift ? v.limb_ [i - 1] >> (32 - shift) : 0);
+  vn [0] = v.limb_ [0] << shift;
+  un [m] = shift ? u.limb_ [m - 1] >> (32 - shift) : 0;
+  for (unsigned i = m - 1; i > 0; i--)
+    un [i] = (u.limb_ [i] << shift) | (shift ? u.limb_ [i - 1] >> (32 - shift) : 0);
+  un [0] = u.limb_ [0] << shift;
+
+  const uint64_t LIMB_BASE = (uint64_t) 1 << 32;
+  BigUInt quotient;
+  for (unsigned j = m - n + 1; j-- > 0; )
+    {
+    // estimate, then correct, the quotient limb
+    const uint64_t top = ((uint64_t) un [j + n] << 32) | un [j + n - 1];
+    uint64_t qhat = top / vn [n - 1];
+    uint64_t rhat = top % vn [n - 1];
+    while (qhat >= LIMB_BASE || qhat * vn [n - 2] > ((rhat << 32) | un [j + n - 2]))
+      {
+      qhat--;
+      rhat += vn [n - 1];
+      if (rhat >= LIMB_BASE)
+        break;
+      }
+
+    // un -= qhat * vn, and if that went below zero, add vn back
+    int64_t borrow = 0;
+    uint64_t carry = 0;
+    for (unsigned i = 0; i < n; i++)
+      {
+      const uint64_t product = qhat * vn [i] + carry;
+      carry = product >> 32;
+      const int64_t difference = (int64_t) un [i + j] - borrow - (int64_t) (product & 0xFFFFFFFFUL);
+      un [i + j] = (uint32_t) difference;
+      borrow = difference < 0 ? 1 : 0;
+      }
+    const int64_t difference = (int64_t) un [j + n] - borrow - (int64_t) carry;
+    un [j + n] = (uint32_t) difference;
+
+    if (difference < 0)
+      {
+      qhat--;
+      uint64_t sum = 0;
+      for (unsigned i = 0; i < n; i++)
+        {
+        sum += (uint64_t) un [i + j] + vn [i];
+        un [i + j] = (uint32_t) sum;
+        sum >>= 32;
+        }
+      un [j + n] += (uint32_t) sum;
+      }
+    quotient.limb_ [j] = (uint32_t) qhat;
+    }
+
+  // the remainder is what is left of un, shifted back
+  BigUInt remainder;
+  for (unsigned i = 0; i < n; i++)
+    remainder.limb_ [i] = (un [i] >> shift) | (shift ? un [i + 1] << (32 - shift) : 0);
+  q = quotient;
+  r = remainder;
+} // end of BigUInt::divMod
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigUInt<Bits>::mulMod (const BigUInt & n, const BigUInt & m) const
+{
+  return BigUInt (mulWide (n) % BigUInt<Bits * 2> (m));
+} // end of BigUInt::mulMod
+
+// right to left binary powers
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigUInt<Bits>::powMod (const BigUInt & power, const BigUInt & m) const
+{
+  if (m.isZero ())
+    return BigUInt ();
+  BigUInt result = BigUInt (1) % m;
+  BigUInt square = *this % m;
+  const unsigned length = power.bitLength ();
+  for (unsigned i = 0; i < length; i++)
+    {
+    if (power.bit (i))
+      result = result.mulMod (square, m);
+    if (i + 1 < length)
+      square = square.mulMod (square, m);
+    }
+  return result;
+} // end of BigUInt::powMod
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigUInt<Bits>::operator~ () const
+{
+  BigUInt result;
+  for (unsigned i = 0; i < LIMBS; i++)
+    result.limb_ [i] = ~ limb_ [i];
+  return result;
+} // end of BigUInt::operator~
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> & BigUInt<Bits>::operator&= (const BigUInt & n)
+{
+  for (unsigned i = 0; i < LIMBS; i++)
+    limb_ [i] &= n.limb_ [i];
+  return *this;
+} // end of BigUInt::operator&=
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> & BigUInt<Bits>::operator|= (const BigUInt & n)
+{
+  for (unsigned i = 0; i < LIMBS; i++)
+    limb_ [i] |= n.limb_ [i];
+  return *this;
+} // end of BigUInt::operator|=
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> & BigUInt<Bits>::operator^= (const BigUInt & n)
+{
+  for (unsigned i = 0; i < LIMBS; i++)
+    limb_ [i] ^= n.limb_ [i];
+  return *this;
+} // end of BigUInt::operator^=
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigUInt<Bits>::operator<< (const unsigned n) const
+{
+  BigUInt result;
+  const unsigned limbs = n / 32;
+  const unsigned bits = n % 32;
+  for (unsigned i = limbs; i < LIMBS; i++)
+    {
+    result.limb_ [i] = limb_ [i - limbs] << bits;
+    if (bits != 0 && i > limbs)
+      result.limb_ [i] |= limb_ [i - limbs - 1] >> (32 - bits);
+    }
+  return result;
+} // end of BigUInt::operator<<
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigUInt<Bits> BigUInt<Bits>::operator>> (const unsigned n) const
+{
+  BigUInt result;
+  const unsigned limbs = n / 32;
+  const unsigned bits = n % 32;
+  for (unsigned i = 0; i + limbs < LIMBS; i++)
+    {
+    result.limb_ [i] = limb_ [i + limbs] >> bits;
+    if (bits != 0 && i + limbs + 1 < LIMBS)
+      result.limb_ [i] |= limb_ [i + limbs + 1] << (32 - bits);
+    }
+  return result;
+} // end of BigUInt::operator>>
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR int BigUInt<Bits>::compare (const BigUInt & a, const BigUInt & b)
+{
+  for (unsigned i = LIMBS; i-- > 0; )
+    if (a.limb_ [i] != b.limb_ [i])
+      return a.limb_ [i] < b.limb_ [i] ? -1 : 1;
+  return 0;
+} // end of BigUInt::compare
+
+// -------------------------------- BigInt --------------------------------
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigInt<Bits>::BigInt (const int64_t n) : bits_ ((uint64_t) n)
+{
+  if (n < 0)
+    for (unsigned i = 2; i < BigUInt<Bits>::LIMBS; i++)
+      bits_.limb_ [i] = 0xFFFFFFFFUL;
+} // end of BigInt::BigInt
+
+template <unsigned Bits>
+BigInt<Bits>::BigInt (const BigNumber & n) : bits_ (n)
+{
+} // end of BigInt::BigInt
+
+template <unsigned Bits>
+BigNumber BigInt<Bits>::toBigNumber () const
+{
+  const BigNumber m = magnitude ().toBigNumber ();
+  return isNegative () ? BigNumber (0) - m : m;
+} // end of BigInt::toBigNumber
+
+template <unsigned Bits>
+size_t BigInt<Bits>::toChars (char * buf, const size_t cap) const
+{
+  if (!isNegative ())
+    return bits_.toChars (buf, cap);
+  const size_t length = magnitude ().toChars (buf == NULL ? NULL : buf + 1, cap > 0 ? cap - 1 : 0) + 1;
+  if (length < cap && buf != NULL)
+    buf [0] = '-';
+  return length;
+} // end of BigInt::toChars
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigInt<Bits> BigInt<Bits>::operator/ (const BigInt & n) const
+{
+  const BigInt q (magnitude () / n.magnitude ());
+  return isNegative () != n.isNegative () ? - q : q;
+} // end of BigInt::operator/
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigInt<Bits> BigInt<Bits>::operator% (const BigInt & n) const
+{
+  const BigInt r (magnitude () % n.magnitude ());
+  return isNegative () ? - r : r;
+} // end of BigInt::operator%
+
+template <unsigned Bits>
+BIGUINT_CONSTEXPR BigInt<Bits> BigInt<Bits>::operator>> (const unsigned n) const
+{
+  if (!isNegative ())
+    return BigInt (bits_ >> n);
+  return ~ BigInt (~ bits_ >> n);
+} // end of BigInt::operator>>
+
+// as unsigned, after flipping the sign bits so negative numbers come first
+template <unsigned Bits>
+BIGUINT_CONSTEXPR int BigInt<Bits>::compare (const BigInt & a, const BigInt & b)
+{
+  BigUInt<Bits> x = a.bits_;
+  BigUInt<Bits> y = b.bits_;
+  x.limb_ [BigUInt<Bits>::LIMBS - 1] ^= 0x80000000UL;
+  y.limb_ [BigUInt<Bits>::LIMBS - 1] ^= 0x80000000UL;
+  return BigUInt<Bits>::compare (x, y);
+} // end of BigInt::compare
+
+#endif
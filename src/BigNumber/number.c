@@ -40,12 +40,67 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <ctype.h>/* Prototypes needed for external utility routines. */
+#include <math.h>
+#include <stdint.h>
 
 /* Storage used for special numbers. */
 bc_num _zero_;
 bc_num _one_;
 bc_num _two_;
 
+/* Polling state, for each thread when there are threads. */
+#if BIGNUMBER_THREADS
+#define BC_THREAD_LOCAL __thread
+#else
+#define BC_THREAD_LOCAL
+#endif
+
+static BC_THREAD_LOCAL bc_poll_handler poll_handler;
+static BC_THREAD_LOCAL void *poll_context;
+static BC_THREAD_LOCAL int poll_depth;
+static BC_THREAD_LOCAL int poll_stopped;
+
+/* Set the poll handler for this thread (NULL for none), and start again
+   after a stop. */
+
+void bc_set_poll_handler (bc_poll_handler handler, void *context)
+{
+  poll_handler = handler;
+  poll_context = context;
+  poll_depth = 0;
+  poll_stopped = FALSE;
+}
+
+/* A loop which reports its progress is entered and left with these, so
+   that only the outermost one's progress is passed on. */
+
+void bc_poll_enter (void)
+{
+  poll_depth++;
+}
+
+void bc_poll_leave (void)
+{
+  poll_depth--;
+}
+
+/* Called by long loops.  Returns TRUE if they should stop. */
+
+int bc_poll (long done, long total)
+{
+  if (poll_stopped) return TRUE;
+  if (poll_handler == NULL) return FALSE;
+  if (poll_depth > 1) done = total = 0;
+  if (poll_handler (poll_context, done, total))
+    poll_stopped = TRUE;
+  return poll_stopped;
+}
+
+int bc_poll_stopped (void)
+{
+  return poll_stopped;
+}
+
 /* new_num allocates a number and sets fields to known values. */
 
 bc_num bc_new_num (int length, int scale)
@@ -71,8 +126,12 @@ bc_num bc_new_num (int length, int scale)
 void bc_free_num (bc_num *num)
 {
   if (*num == NULL) return;
+#if BIGNUMBER_THREADS
+  if (__atomic_sub_fetch (&(*num)->n_refs, 1, __ATOMIC_ACQ_REL) == 0) {
+#else
   (*num)->n_refs--;
   if ((*num)->n_refs == 0) {
+#endif
     if ((*num)->n_ptr)
       free ((*num)->n_ptr);
     free (*num);
@@ -97,7 +156,11 @@ void bc_init_numbers ()
 
 bc_num bc_copy_num (bc_num num)
 {
+#if BIGNUMBER_THREADS
+  __atomic_add_fetch (&num->n_refs, 1, __ATOMIC_RELAXED);
+#else
   num->n_refs++;
+#endif
   return num;
 }
 
@@ -598,24 +661,28 @@ static bc_num new_sub_num (int length, int scale, char *value)
   return temp;
 }
 
+/* The simple multiply.  Only the columns (powers of ten) of the product
+   from SKIP up are worked out: the digits below are left zero, and so are
+   the carries from them. */
 static void
-_bc_simp_mul (bc_num n1, int n1len, bc_num n2, int n2len, bc_num *prod)
+_bc_simp_mul (bc_num n1, int n1len, bc_num n2, int n2len, int skip, bc_num *prod)
 {
   char *n1ptr, *n2ptr, *pvptr;
   char *n1end, *n2end;          /* To the end of n1 and n2. */
   int indx, sum, prodlen;
 
   prodlen = n1len+n2len+1;
+  skip = MIN(skip, prodlen-1);
 
   *prod = bc_new_num (prodlen, 0);
 
   n1end = (char *) (n1->n_value + n1len - 1);
   n2end = (char *) (n2->n_value + n2len - 1);
-  pvptr = (char *) ((*prod)->n_value + prodlen - 1);
+  pvptr = (char *) ((*prod)->n_value + prodlen - 1 - skip);
   sum = 0;
 
   /* Here is the loop... */
-  for (indx = 0; indx < prodlen-1; indx++)
+  for (indx = skip; indx < prodlen-1; indx++)
     {
       n1ptr = (char *) (n1end - MAX(0, indx-n2len+1));
       n2ptr = (char *) (n2end - MIN(indx, n2len-1));
@@ -710,7 +777,7 @@ _bc_rec_mul (bc_num u, int ulen, bc_num v, int vlen, bc_num *prod)
   if ((ulen+vlen) < mul_base_digits
       || ulen < MUL_SMALL_DIGITS
       || vlen < MUL_SMALL_DIGITS ) {
-    _bc_simp_mul (u, ulen, v, vlen, prod);
+    _bc_simp_mul (u, ulen, v, vlen, 0, prod);
     return;
   }
 
@@ -789,24 +856,114 @@ _bc_rec_mul (bc_num u, int ulen, bc_num v, int vlen, bc_num *prod)
   bc_free_num (&d2);
 }
 
+/* About the digit multiplications _bc_rec_mul does for ULEN by VLEN
+   digits (with a little for the adds). */
+static long
+_bc_mul_cost (int ulen, int vlen)
+{
+  int n;
+
+  if ((ulen+vlen) < mul_base_digits
+      || ulen < MUL_SMALL_DIGITS
+      || vlen < MUL_SMALL_DIGITS )
+    return (long) ulen * vlen;
+  n = (MAX(ulen, vlen)+1) / 2;
+  return _bc_mul_cost (MAX(ulen-n, 1), MAX(vlen-n, 1)) + _bc_mul_cost (n, n)
+         + _bc_mul_cost (MIN(ulen, n), MIN(vlen, n)) + 4L * (ulen+vlen);
+}
+
+/* The digit multiplications _bc_simp_mul does for the columns from CUT
+   up of LEN1 by LEN2 digits. */
+static long
+_bc_short_cost (int len1, int len2, int cut)
+{
+  long cost = (long) len1 * len2;
+  int col;
+
+  for (col = 0; col < cut && col < len1+len2-1; col++)
+    cost -= MIN(col, len1-1) - MAX(0, col-len2+1) + 1;
+  return cost;
+}
+
+/* The short product, for when the last DROP digits of the product of
+   N1 and N2 are to be dropped: only the columns from CUT up, a few guard
+   digits below DROP, are worked out.  What that leaves out is less than
+   9 * MIN(LEN1, LEN2) * 10^CUT, which the guard digits make less than
+   10^(DROP-2), so unless the two digits just above the ones dropped are
+   both 9 (where the carry from what was left out might reach the digits
+   kept) the digits kept are exactly those of the full product.  Returns 0
+   without a product if that check fails, or if the full product would be
+   as quick. */
+static int
+_bc_short_mul (bc_num n1, int len1, bc_num n2, int len2, int drop, bc_num *prod)
+{
+  char *digit;
+  long bound;
+  int guard, cut;
+
+  guard = 2;
+  for (bound = 9L * MIN(len1, len2); bound > 0; bound /= 10)
+    guard++;
+  cut = drop - guard;
+  if (cut <= 0 || _bc_short_cost (len1, len2, cut) >= _bc_mul_cost (len1, len2))
+    return 0;
+
+  _bc_simp_mul (n1, len1, n2, len2, cut, prod);
+  digit = (*prod)->n_value + len1 + len2 - drop + 1;  /* column DROP-1 */
+  if (digit[0] == BASE-1 && digit[1] == BASE-1)
+    {
+      bc_free_num (prod);
+      return 0;
+    }
+  return 1;
+}
+
+/* The zeros at the end of the LEN digits of NUM, leaving at least one
+   digit. */
+static int
+_bc_trailing_zeros (bc_num num, int len)
+{
+  int zeros = 0;
+
+  while (zeros < len-1 && num->n_value[len-1-zeros] == 0)
+    zeros++;
+  return zeros;
+}
+
 /* The multiply routine.  N2 times N1 is put int PROD with the scale of
    the result being MIN(N2 scale+N1 scale, MAX (SCALE, N2 scale, N1 scale)).
-   */
+   Zeros at the end of either number (as in 1.5000 or 25000) are left out
+   of the multiply and put back after, and when enough of the digits are
+   dropped, the short product is tried first. */
 
 void bc_multiply (bc_num n1, bc_num n2, bc_num *prod, int scale)
 {
-  bc_num pval;
-  int len1, len2;
-  int full_scale, prod_scale;
+  bc_num pval, padded;
+  int len1, len2, zeros1, zeros2;
+  int full_scale, prod_scale, drop;
 
   /* Initialize things. */
   len1 = n1->n_len + n1->n_scale;
   len2 = n2->n_len + n2->n_scale;
   full_scale = n1->n_scale + n2->n_scale;
   prod_scale = MIN(full_scale,MAX(scale,MAX(n1->n_scale,n2->n_scale)));
+  drop = full_scale - prod_scale;
+  zeros1 = _bc_trailing_zeros (n1, len1);
+  zeros2 = _bc_trailing_zeros (n2, len2);
 
-  /* Do the multiply */
-  _bc_rec_mul (n1, len1, n2, len2, &pval);
+  /* Do the multiply, without the zeros. */
+  if (!_bc_short_mul (n1, len1-zeros1, n2, len2-zeros2,
+                      drop - zeros1 - zeros2, &pval))
+    _bc_rec_mul (n1, len1-zeros1, n2, len2-zeros2, &pval);
+
+  /* Put back the zeros which are not dropped. */
+  if (zeros1 + zeros2 > drop)
+    {
+      padded = bc_new_num (len1 + len2 + 1 - drop, 0);
+      memcpy (padded->n_ptr, pval->n_ptr, len1 + len2 + 1 - zeros1 - zeros2);
+      bc_free_num (&pval);
+      pval = padded;
+    }
 
   /* Assign to prod and clean up the number. */
   pval->n_sign = ( n1->n_sign == n2->n_sign ? PLUS : MINUS );
@@ -859,35 +1016,40 @@ static void _one_mult (unsigned char *num, int size, int digit, unsigned char *r
 /* The full division routine. This computes N1 / N2.  It returns
    0 if the division is ok and the result is in QUOT.  The number of
    digits after the decimal point is SCALE. It returns -1 if division
-   by zero is tried.  The algorithm is found in Knuth Vol 2. p237. */
+   by zero is tried.  The algorithm is found in Knuth Vol 2. p237.
 
-int bc_divide (bc_num n1, bc_num n2, bc_num *quot, int scale)
+   The division can also be done a piece at a time: bc_divide_start sets
+   it up in a bc_divide_state, each bc_divide_step works out some of the
+   quotient digits, and bc_divide_finish gives the quotient (or
+   bc_divide_abandon gives up).  N1 and N2 are not needed after the start. */
+
+int bc_divide_start (bc_divide_state *st, bc_num n1, bc_num n2, int scale)
 {
-  bc_num qval;
-  unsigned char *num1, *num2;
-  unsigned char *ptr1, *ptr2, *n2ptr, *qptr;
-  int  scale1, val;
-  unsigned int  len1, len2, scale2, qdigits, extra, count;
-  unsigned int  qdig, qguess, borrow, carry;
-  unsigned char *mval;
-  char zero;
+  unsigned char *n2ptr;
+  int  scale1;
+  unsigned int  len1, len2, scale2, qdigits, extra;
   unsigned int  norm;
 
+  st->num1 = st->num2 = st->mval = NULL;
+  st->qptr = st->n2ptr = NULL;
+  st->qval = NULL;
+  st->qdig = st->qlast = st->len2 = 0;
+
   /* Test for divide by zero. */
   if (bc_is_zero (n2)) return -1;
 
+  st->qsign = (n1->n_sign == n2->n_sign ? PLUS : MINUS);
+
   /* Test for divide by 1.  If it is we must truncate. */
   if (n2->n_scale == 0)
     {
       if (n2->n_len == 1 && *n2->n_value == 1)
         {
-          qval = bc_new_num (n1->n_len, scale);
-          qval->n_sign = (n1->n_sign == n2->n_sign ? PLUS : MINUS);
-          memset (&qval->n_value[n1->n_len],0,scale);
-          memcpy (qval->n_value, n1->n_value,
+          st->qval = bc_new_num (n1->n_len, scale);
+          memset (&st->qval->n_value[n1->n_len],0,scale);
+          memcpy (st->qval->n_value, n1->n_value,
                   n1->n_len + MIN(n1->n_scale,scale));
-          bc_free_num (quot);
-          *quot = qval;
+          return 0;
         }
     }
 
@@ -903,17 +1065,17 @@ int bc_divide (bc_num n1, bc_num n2, bc_num *quot, int scale)
     extra = scale - scale1;
   else
     extra = 0;
-  num1 = (unsigned char *) malloc (n1->n_len+n1->n_scale+extra+2);
-  if (num1 == NULL) bc_out_of_memory();
-  memset (num1, 0, n1->n_len+n1->n_scale+extra+2);
-  memcpy (num1+1, n1->n_value, n1->n_len+n1->n_scale);
+  st->num1 = (unsigned char *) malloc (n1->n_len+n1->n_scale+extra+2);
+  if (st->num1 == NULL) bc_out_of_memory();
+  memset (st->num1, 0, n1->n_len+n1->n_scale+extra+2);
+  memcpy (st->num1+1, n1->n_value, n1->n_len+n1->n_scale);
 
   len2 = n2->n_len + scale2;
-  num2 = (unsigned char *) malloc (len2+1);
-  if (num2 == NULL) bc_out_of_memory();
-  memcpy (num2, n2->n_value, len2);
-  *(num2+len2) = 0;
-  n2ptr = num2;
+  st->num2 = (unsigned char *) malloc (len2+1);
+  if (st->num2 == NULL) bc_out_of_memory();
+  memcpy (st->num2, n2->n_value, len2);
+  *(st->num2+len2) = 0;
+  n2ptr = st->num2;
   while (*n2ptr == 0)
     {
       n2ptr++;
@@ -922,13 +1084,9 @@ int bc_divide (bc_num n1, bc_num n2, bc_num *quot, int scale)
 
   /* Calculate the number of quotient digits. */
   if (len2 > len1+scale)
-    {
-      qdigits = scale+1;
-      zero = TRUE;
-    }
+    qdigits = scale+1;
   else
     {
-      zero = FALSE;
       if (len2>len1)
         qdigits = scale+1;      /* One for the zero integer part. */
       else
@@ -936,115 +1094,181 @@ int bc_divide (bc_num n1, bc_num n2, bc_num *quot, int scale)
     }
 
   /* Allocate and zero the storage for the quotient. */
-  qval = bc_new_num (qdigits-scale,scale);
-  memset (qval->n_value, 0, qdigits);
+  st->qval = bc_new_num (qdigits-scale,scale);
+  memset (st->qval->n_value, 0, qdigits);
 
   /* Allocate storage for the temporary storage mval. */
-  mval = (unsigned char *) malloc (len2+1);
-  if (mval == NULL) bc_out_of_memory ();
+  st->mval = (unsigned char *) malloc (len2+1);
+  if (st->mval == NULL) bc_out_of_memory ();
 
   /* Now for the full divide algorithm. */
-  if (!zero)
+  if (len2 <= len1+scale)
     {
       /* Normalize */
       norm =  10 / ((int)*n2ptr + 1);
       if (norm != 1)
         {
-          _one_mult (num1, len1+scale1+extra+1, norm, num1);
+          _one_mult (st->num1, len1+scale1+extra+1, norm, st->num1);
           _one_mult (n2ptr, len2, norm, n2ptr);
         }
 
       /* Initialize divide loop. */
-      qdig = 0;
+      st->qdig = 0;
+      st->qlast = len1+scale-len2+1;
       if (len2 > len1)
-        qptr = (unsigned char *) qval->n_value+len2-len1;
+        st->qptr = (unsigned char *) st->qval->n_value+len2-len1;
       else
-        qptr = (unsigned char *) qval->n_value;
+        st->qptr = (unsigned char *) st->qval->n_value;
+    }
+  st->n2ptr = n2ptr;
+  st->len2 = len2;
+  return 0;
+}
+
+/* Work out quotient digits until they are all done (when it returns TRUE)
+   or BUDGET, counted in single digit operations, runs out.  BUDGET is
+   reduced by the work done; a negative BUDGET means no limit.  At least
+   one digit is done each time. */
+
+int bc_divide_step (bc_divide_state *st, long *budget)
+{
+  unsigned char *num1, *n2ptr, *mval;
+  unsigned char *ptr1, *ptr2;
+  int  val;
+  unsigned int  len2, count;
+  unsigned int  qdig, qguess, borrow, carry;
+
+  num1 = st->num1;
+  n2ptr = st->n2ptr;
+  mval = st->mval;
+  len2 = st->len2;
+  qdig = st->qdig;
 
-      /* Loop */
-      while (qdig <= len1+scale-len2)
+  /* Loop */
+  while (qdig < st->qlast)
+    {
+      if (*budget >= 0 && qdig > st->qdig && *budget < (long) len2+1)
+        break;
+      if ((qdig & 15) == 0 && bc_poll (qdig, st->qlast))
         {
-          /* Calculate the quotient digit guess. */
-          if (*n2ptr == num1[qdig])
-            qguess = 9;
-          else
-            qguess = (num1[qdig]*10 + num1[qdig+1]) / *n2ptr;
+          qdig = st->qlast;
+          break;
+        }
 
-          /* Test qguess. */
+      /* Calculate the quotient digit guess. */
+      if (*n2ptr == num1[qdig])
+        qguess = 9;
+      else
+        qguess = (num1[qdig]*10 + num1[qdig+1]) / *n2ptr;
+
+      /* Test qguess. */
+      if (n2ptr[1]*qguess >
+          (num1[qdig]*10 + num1[qdig+1] - *n2ptr*qguess)*10
+           + num1[qdig+2])
+        {
+          qguess--;
+          /* And again. */
           if (n2ptr[1]*qguess >
               (num1[qdig]*10 + num1[qdig+1] - *n2ptr*qguess)*10
-               + num1[qdig+2])
-            {
-              qguess--;
-              /* And again. */
-              if (n2ptr[1]*qguess >
-                  (num1[qdig]*10 + num1[qdig+1] - *n2ptr*qguess)*10
-                  + num1[qdig+2])
-                qguess--;
-            }
+              + num1[qdig+2])
+            qguess--;
+        }
 
-          /* Multiply and subtract. */
-          borrow = 0;
-          if (qguess != 0)
+      /* Multiply and subtract. */
+      borrow = 0;
+      if (qguess != 0)
+        {
+          *mval = 0;
+          _one_mult (n2ptr, len2, qguess, mval+1);
+          ptr1 = (unsigned char *) num1+qdig+len2;
+          ptr2 = (unsigned char *) mval+len2;
+          for (count = 0; count < len2+1; count++)
             {
-              *mval = 0;
-              _one_mult (n2ptr, len2, qguess, mval+1);
-              ptr1 = (unsigned char *) num1+qdig+len2;
-              ptr2 = (unsigned char *) mval+len2;
-              for (count = 0; count < len2+1; count++)
+              val = (int) *ptr1 - (int) *ptr2-- - borrow;
+              if (val < 0)
                 {
-                  val = (int) *ptr1 - (int) *ptr2-- - borrow;
-                  if (val < 0)
-                    {
-                      val += 10;
-                      borrow = 1;
-                    }
-                  else
-                    borrow = 0;
-                  *ptr1-- = val;
+                  val += 10;
+                  borrow = 1;
                 }
+              else
+                borrow = 0;
+              *ptr1-- = val;
             }
+        }
 
-          /* Test for negative result. */
-          if (borrow == 1)
+      /* Test for negative result. */
+      if (borrow == 1)
+        {
+          qguess--;
+          ptr1 = (unsigned char *) num1+qdig+len2;
+          ptr2 = (unsigned char *) n2ptr+len2-1;
+          carry = 0;
+          for (count = 0; count < len2; count++)
             {
-              qguess--;
-              ptr1 = (unsigned char *) num1+qdig+len2;
-              ptr2 = (unsigned char *) n2ptr+len2-1;
-              carry = 0;
-              for (count = 0; count < len2; count++)
+              val = (int) *ptr1 + (int) *ptr2-- + carry;
+              if (val > 9)
                 {
-                  val = (int) *ptr1 + (int) *ptr2-- + carry;
-                  if (val > 9)
-                    {
-                      val -= 10;
-                      carry = 1;
-                    }
-                  else
-                    carry = 0;
-                  *ptr1-- = val;
+                  val -= 10;
+                  carry = 1;
                 }
-              if (carry == 1) *ptr1 = (*ptr1 + 1) % 10;
+              else
+                carry = 0;
+              *ptr1-- = val;
             }
-
-          /* We now know the quotient digit. */
-          *qptr++ =  qguess;
-          qdig++;
+          if (carry == 1) *ptr1 = (*ptr1 + 1) % 10;
         }
+
+      /* We now know the quotient digit. */
+      *st->qptr++ =  qguess;
+      qdig++;
+      if (*budget >= 0)
+        *budget -= len2+1;
     }
 
+  st->qdig = qdig;
+  return qdig >= st->qlast;
+}
+
+/* Put the quotient in QUOT and free the working storage. */
+
+void bc_divide_finish (bc_divide_state *st, bc_num *quot)
+{
+  bc_num qval;
+
   /* Clean up and return the number. */
-  qval->n_sign = ( n1->n_sign == n2->n_sign ? PLUS : MINUS );
+  qval = st->qval;
+  st->qval = NULL;
+  qval->n_sign = st->qsign;
   if (bc_is_zero (qval)) qval->n_sign = PLUS;
   _bc_rm_leading_zeros (qval);
   bc_free_num (quot);
   *quot = qval;
+  bc_divide_abandon (st);
+}
 
+/* Free the working storage of a division (which need not be finished). */
+
+void bc_divide_abandon (bc_divide_state *st)
+{
   /* Clean up temporary storage. */
-  free (mval);
-  free (num1);
-  free (num2);
+  bc_free_num (&st->qval);
+  free (st->mval);
+  free (st->num1);
+  free (st->num2);
+  st->mval = st->num1 = st->num2 = NULL;
+}
 
+int bc_divide (bc_num n1, bc_num n2, bc_num *quot, int scale)
+{
+  bc_divide_state st;
+  long budget = -1;
+
+  if (bc_divide_start (&st, n1, n2, scale) != 0)
+    return -1;
+  bc_poll_enter ();
+  bc_divide_step (&st, &budget);
+  bc_poll_leave ();
+  bc_divide_finish (&st, quot);
   return 0;     /* Everything is OK. */
 }
 
@@ -1101,6 +1325,7 @@ int bc_raisemod (bc_num base, bc_num expo, bc_num mod, bc_num *result, int scale
 {
   bc_num power, exponent, parity, temp;
   int rscale;
+  long bits, total;
 
   /* Check for correct numbers. */
   if (bc_is_zero(mod)) return -1;
@@ -1129,8 +1354,13 @@ int bc_raisemod (bc_num base, bc_num expo, bc_num mod, bc_num *result, int scale
 
   /* Do the calculation. */
   rscale = MAX(scale, base->n_scale);
+  bits = 0;
+  total = (long) exponent->n_len * 10 / 3 + 1;  /* about log2 (10) bits a digit */
+  bc_poll_enter ();
   while ( !bc_is_zero(exponent) )
     {
+      if (bc_poll (bits++, total))
+        break;
       (void) bc_divmod (exponent, _two_, &exponent, &parity, 0);
       if ( !bc_is_zero(parity) )
         {
@@ -1141,6 +1371,7 @@ int bc_raisemod (bc_num base, bc_num expo, bc_num mod, bc_num *result, int scale
       bc_multiply (power, power, &power, rscale);
       (void) bc_modulo (power, mod, &power, scale);
     }
+  bc_poll_leave ();
 
   /* Assign the value. */
   bc_free_num (&power);
@@ -1151,71 +1382,171 @@ int bc_raisemod (bc_num base, bc_num expo, bc_num mod, bc_num *result, int scale
   return 0;     /* Everything is OK. */
 }
 
+/* Convert the integer part of NUM to binary.  The bits are returned
+   least significant first, one per byte, in a malloc'ed array which
+   the caller must free.  The number of bits is put in NBITS.  This
+   works for integers of any length. */
+
+static unsigned char *_bc_num2bits (bc_num num, int *nbits)
+{
+  unsigned char *digits, *bits;
+  int first, index, rem, val;
+
+  digits = (unsigned char *) malloc (num->n_len);
+  bits = (unsigned char *) malloc (num->n_len * 4 + 1);
+  if (digits == NULL || bits == NULL) bc_out_of_memory ();
+  memcpy (digits, num->n_value, num->n_len);
+
+  /* Halve the decimal digits repeatedly, collecting the remainders. */
+  *nbits = 0;
+  first = 0;
+  while (first < num->n_len && digits[first] == 0) first++;
+  while (first < num->n_len)
+    {
+      rem = 0;
+      for (index = first; index < num->n_len; index++)
+        {
+          val = rem * BASE + digits[index];
+          digits[index] = val >> 1;
+          rem = val & 1;
+        }
+      bits[(*nbits)++] = rem;
+      while (first < num->n_len && digits[first] == 0) first++;
+    }
+
+  free (digits);
+  return bits;
+}
+
+/* Estimate log10 of the magnitude of NUM from its leading digits.
+   NUM must not be zero. */
+
+static double _bc_log10 (bc_num num)
+{
+  char *nptr;
+  int count, lead, digits;
+  double val;
+
+  nptr = num->n_value;
+  count = num->n_len + num->n_scale;
+  lead = num->n_len;
+
+  /* Skip the leading zeros of a fraction. */
+  while (count > 0 && *nptr == 0)
+    {
+      nptr++;
+      count--;
+      lead--;
+    }
+
+  val = 0;
+  for (digits = 0; digits < 15 && count > 0; digits++, count--)
+    val = val * BASE + *nptr++;
+
+  return log10 (val) + lead - digits;
+}
+
 /* Raise NUM1 to the NUM2 power.  The result is placed in RESULT.
-   Maximum exponent is LONG_MAX.  If a NUM2 is not an integer,
-   only the integer part is used.  */
+   The exponent may be of any size.  If a NUM2 is not an integer,
+   only the integer part is used.
+
+   Integer bases give exact results.  For a base with a fraction the
+   intermediate powers are truncated to the result scale plus enough
+   guard digits to cover the error of the square and multiply chain
+   (which is amplified by the exponent and the size of the result),
+   rather than letting the scale double on every squaring. */
 
 void bc_raise (bc_num num1, bc_num num2, bc_num *result, int scale)
 {
    bc_num temp, power;
+   unsigned char *bits;
+   int nbits, bit;
    long exponent;
+   double expo_val, magnitude, extra;
    int rscale;
-   int pwrscale;
    int calcscale;
+   int index;
    char neg;
 
-   /* Check the exponent for scale digits and convert to a long. */
+   /* Check the exponent for scale digits. */
    if (num2->n_scale != 0)
      bc_rt_warn (BC_WARNING_NON_ZERO_SCALE_IN_EXPONENT);
-   exponent = bc_num2long (num2);
-   if (exponent == 0 && (num2->n_len > 1 || num2->n_value[0] != 0))
-       bc_rt_error (BC_ERROR_EXPONENT_TOO_LARGE_IN_RAISE);
+
+   /* Get the bits of the exponent, least significant first. */
+   bits = _bc_num2bits (num2, &nbits);
 
    /* Special case if exponent is a zero. */
-   if (exponent == 0)
+   if (nbits == 0)
      {
+       free (bits);
        bc_free_num (result);
        *result = bc_copy_num (_one_);
        return;
      }
 
-   /* Other initializations. */
+   /* The exponent as a long (LONG_MAX if it is larger) and as a double,
+      for working out the scales. */
+   exponent = bc_num2long (num2);
+   if (exponent == 0)
+     exponent = LONG_MAX;
    if (exponent < 0)
-     {
-       neg = TRUE;
-       exponent = -exponent;
-       rscale = scale;
-     }
+     exponent = -exponent;
+   expo_val = 0;
+   for (index = 0; index < num2->n_len; index++)
+     expo_val = expo_val * BASE + num2->n_value[index];
+
+   /* Other initializations. */
+   neg = bc_is_neg (num2);
+   if (neg)
+     rscale = scale;
+   else if (num1->n_scale == 0)
+     rscale = 0;
+   else if (exponent > MAX(scale, num1->n_scale) / num1->n_scale)
+     rscale = MAX(scale, num1->n_scale);
    else
+     rscale = MIN (num1->n_scale*exponent, MAX(scale, num1->n_scale));
+
+   /* Work out the scale of the intermediate results.  Truncation errors
+      grow in proportion to the exponent, so allow for its digits, and
+      for large results (or for small ones we take the reciprocal of)
+      allow for the digits in front of the decimal point. */
+   calcscale = rscale;
+   if (num1->n_scale != 0)
      {
-       neg = FALSE;
-       rscale = MIN (num1->n_scale*exponent, MAX(scale, num1->n_scale));
+       extra = num2->n_len + 2;
+       if (!bc_is_zero (num1))
+         {
+           magnitude = expo_val * _bc_log10 (num1);
+           if (!neg && magnitude > 0)
+             extra += ceil (magnitude);
+           if (neg && magnitude < 0)
+             extra -= 2 * floor (magnitude);
+         }
+       if (extra > INT_MAX / 4 - rscale)
+         extra = INT_MAX / 4 - rscale;
+       calcscale = rscale + (int) extra;
      }
 
-   /* Set initial value of temp.  */
+   /* Do the calculation, right to left binary method. */
    power = bc_copy_num (num1);
-   pwrscale = num1->n_scale;
-   while ((exponent & 1) == 0)
+   temp = NULL;
+   bc_poll_enter ();
+   for (bit = 0; bit < nbits; bit++)
      {
-       pwrscale = 2*pwrscale;
-       bc_multiply (power, power, &power, pwrscale);
-       exponent = exponent >> 1;
-     }
-   temp = bc_copy_num (power);
-   calcscale = pwrscale;
-   exponent = exponent >> 1;
-
-   /* Do the calculation. */
-   while (exponent > 0)
-     {
-       pwrscale = 2*pwrscale;
-       bc_multiply (power, power, &power, pwrscale);
-       if ((exponent & 1) == 1) {
-         calcscale = pwrscale + calcscale;
-         bc_multiply (temp, power, &temp, calcscale);
-       }
-       exponent = exponent >> 1;
+       if (bc_poll (bit, nbits) && temp != NULL)
+         break;
+       if (bits[bit])
+         {
+           if (temp == NULL)
+             temp = bc_copy_num (power);
+           else
+             bc_multiply (temp, power, &temp, calcscale);
+         }
+       if (bit < nbits - 1)
+         bc_multiply (power, power, &power, calcscale);
      }
+   bc_poll_leave ();
+   free (bits);
 
    /* Assign the value. */
    if (neg)
@@ -1295,8 +1626,11 @@ int bc_sqrt (bc_num *num, int scale)
 
   /* Find the square root using Newton's algorithm. */
   done = FALSE;
+  bc_poll_enter ();
   while (!done)
     {
+      if (bc_poll (cscale, rscale+1))
+        break;
       bc_free_num (&guess1);
       guess1 = bc_copy_num (guess);
       bc_divide (*num, guess, &guess, cscale);
@@ -1311,6 +1645,7 @@ int bc_sqrt (bc_num *num, int scale)
             done = TRUE;
         }
     }
+  bc_poll_leave ();
 
   /* Assign the number and clean up. */
   bc_free_num (num);
@@ -1495,6 +1830,422 @@ void bc_str2num (bc_num *num, const char *str, int scale)
     }
 }
 
+/* Words of ASCII digits are checked and converted several at a time:
+   a word is all digits if every byte is 0x30 to 0x39, and the digits
+   are then the bytes less 0x30, as the numbers store one per byte. */
+
+#if UINTPTR_MAX > 0xFFFFFFFFUL
+typedef uint64_t bc_word;
+#define BC_WORD_BYTES(b) ((bc_word) 0x0101010101010101ULL * (b))
+#else
+typedef uint32_t bc_word;
+#define BC_WORD_BYTES(b) ((bc_word) 0x01010101UL * (b))
+#endif
+
+/* The number of decimal digits at the start of the LENGTH characters
+   at STR. */
+
+static size_t _bc_digit_run (const char *str, size_t length)
+{
+  size_t count;
+  bc_word word;
+
+  count = 0;
+  while (length - count >= sizeof (bc_word))
+    {
+      memcpy (&word, str + count, sizeof (bc_word));
+      if ((word & BC_WORD_BYTES (0xF0)) != BC_WORD_BYTES (0x30)
+	  || ((word + BC_WORD_BYTES (0x06)) & BC_WORD_BYTES (0xF0)) != BC_WORD_BYTES (0x30))
+	break;
+      count += sizeof (bc_word);
+    }
+  while (count < length && isdigit ((int) str[count]))
+    count++;
+  return count;
+}
+
+/* The number of characters at the start of the LENGTH characters at STR
+   which are digits, or underscores between digits if UNDERSCORES is set.
+   The digits are counted in *DIGITS. */
+
+static size_t _bc_digit_span (const char *str, size_t length, int underscores,
+			      int *digits)
+{
+  size_t count, run;
+
+  count = _bc_digit_run (str, length);
+  *digits = (int) count;
+  if (underscores)
+    while (count > 0 && count + 1 < length && str[count] == '_'
+	   && isdigit ((int) str[count+1]))
+      {
+	run = _bc_digit_run (str + count + 1, length - count - 1);
+	count += run + 1;
+	*digits += (int) run;
+      }
+  return count;
+}
+
+/* Copy COUNT digits from the characters at STR to DIGITS, skipping any
+   underscores, and return where the characters finished. */
+
+static const char *_bc_copy_digits (char *digits, const char *str, int count)
+{
+  bc_word word;
+
+  while (count > 0)
+    {
+      if (count >= (int) sizeof (bc_word))
+	{
+	  memcpy (&word, str, sizeof (bc_word));
+	  if ((word & BC_WORD_BYTES (0xF0)) == BC_WORD_BYTES (0x30)
+	      && ((word + BC_WORD_BYTES (0x06)) & BC_WORD_BYTES (0xF0)) == BC_WORD_BYTES (0x30))
+	    {
+	      word -= BC_WORD_BYTES (0x30);
+	      memcpy (digits, &word, sizeof (bc_word));
+	      digits += sizeof (bc_word);
+	      str += sizeof (bc_word);
+	      count -= sizeof (bc_word);
+	      continue;
+	    }
+	}
+      if (*str != '_')
+	{
+	  *digits++ = CH_VAL(*str);
+	  count--;
+	}
+      str++;
+    }
+  return str;
+}
+
+/* Convert the LENGTH characters at STR, which need not end in a NUL,
+   to a bc number in NUM, keeping at most SCALE decimal places.  The
+   number is an optional sign, digits, and an optional decimal point and
+   more digits.  FLAGS can allow underscores between digits
+   (BC_PARSE_UNDERSCORES) and an exponent such as e-7 (BC_PARSE_EXPONENT).
+   The number of characters used is put in *CONSUMED (if not NULL).
+   Returns BC_PARSE_OK if all the characters made a number,
+   BC_PARSE_TRAILING if only the first *CONSUMED did, or otherwise
+   BC_PARSE_NO_DIGITS or BC_PARSE_RANGE with NUM set to zero. */
+
+int bc_parse_num (bc_num *num, const char *str, size_t length, int scale,
+		  int flags, size_t *consumed)
+{
+  size_t pos, int_start, frac_start, exp_pos;
+  int int_digits, frac_digits, exp_digits, zeros, exponent, places;
+  char negative;
+  const char *ptr;
+  bc_num temp;
+
+  bc_free_num (num);
+  if (consumed != NULL)
+    *consumed = 0;
+
+  /* Find the parts of the number. */
+  pos = 0;
+  negative = FALSE;
+  if (pos < length && (str[pos] == '+' || str[pos] == '-'))
+    negative = str[pos++] == '-';
+  int_start = pos;
+  pos += _bc_digit_span (str + pos, length - pos, flags & BC_PARSE_UNDERSCORES,
+			 &int_digits);
+  frac_start = pos;
+  frac_digits = 0;
+  if (pos < length && str[pos] == '.')
+    {
+      frac_start = ++pos;
+      pos += _bc_digit_span (str + pos, length - pos,
+			     flags & BC_PARSE_UNDERSCORES, &frac_digits);
+    }
+  if (int_digits + frac_digits == 0)
+    {
+      *num = bc_copy_num (_zero_);
+      return BC_PARSE_NO_DIGITS;
+    }
+
+  /* The exponent, if there is one: only taken if it has digits. */
+  exponent = 0;
+  if ((flags & BC_PARSE_EXPONENT) && pos < length
+      && (str[pos] == 'e' || str[pos] == 'E'))
+    {
+      exp_pos = pos + 1;
+      if (exp_pos < length && (str[exp_pos] == '+' || str[exp_pos] == '-'))
+	exp_pos++;
+      exp_digits = (int) _bc_digit_run (str + exp_pos, length - exp_pos);
+      if (exp_digits > 0)
+	{
+	  for (ptr = str + exp_pos; ptr < str + exp_pos + exp_digits; ptr++)
+	    {
+	      if (exponent > (INT_MAX - 9) / 10)
+		{
+		  *num = bc_copy_num (_zero_);
+		  return BC_PARSE_RANGE;
+		}
+	      exponent = exponent * 10 + CH_VAL(*ptr);
+	    }
+	  if (str[pos+1] == '-')
+	    exponent = -exponent;
+	  pos = exp_pos + exp_digits;
+	}
+    }
+  if (consumed != NULL)
+    *consumed = pos;
+
+  /* Skip leading zeros of the whole number. */
+  ptr = str + int_start;
+  zeros = 0;
+  while (zeros < int_digits && (*ptr == '0' || *ptr == '_'))
+    {
+      if (*ptr++ == '0')
+	zeros++;
+    }
+  int_digits -= zeros;
+
+  /* The places needed before the exponent moves the decimal point. */
+  places = frac_digits;
+  if (exponent == 0)
+    places = MIN(places, scale);
+  else if (int_digits + (long) exponent > INT_MAX / 2
+	   || frac_digits - (long) exponent > INT_MAX / 2)
+    {
+      *num = bc_copy_num (_zero_);
+      return BC_PARSE_RANGE;
+    }
+
+  /* Build the number. */
+  temp = bc_new_num (int_digits > 0 ? int_digits : 1, places);
+  if (int_digits > 0)
+    _bc_copy_digits (temp->n_value, ptr, int_digits);
+  if (places > 0)
+    _bc_copy_digits (temp->n_value + temp->n_len, str + frac_start, places);
+
+  if (exponent != 0)
+    {
+      bc_shift_num (temp, exponent, num);
+      bc_free_num (&temp);
+      temp = *num;
+      *num = NULL;
+      if (temp->n_scale > scale)
+	temp->n_scale = MAX(scale, 0);
+    }
+  temp->n_sign = negative && !bc_is_zero (temp) ? MINUS : PLUS;
+  *num = temp;
+
+  return pos < length ? BC_PARSE_TRAILING : BC_PARSE_OK;
+}
+
+/* Multiply NUM by 10 to the power PLACES (divide if PLACES is negative)
+   and put the result in RESULT.  This just moves the decimal point, so
+   it is linear in the length of NUM.  No digits are lost: shifting
+   right increases the scale. */
+
+void bc_shift_num (bc_num num, int places, bc_num *result)
+{
+  bc_num temp;
+  int newlen, newscale, lead, trail;
+
+  newlen = num->n_len + places;
+  newscale = num->n_scale - places;
+  lead = (newlen < 1) ? 1 - newlen : 0;     /* zeros in front */
+  trail = (newscale < 0) ? -newscale : 0;   /* zeros at the end */
+
+  temp = bc_new_num (newlen + lead, newscale + trail);
+  memcpy (temp->n_value + lead, num->n_value, num->n_len + num->n_scale);
+  temp->n_sign = num->n_sign;
+  _bc_rm_leading_zeros (temp);
+  if (bc_is_zero (temp))
+    temp->n_sign = PLUS;
+
+  bc_free_num (result);
+  *result = temp;
+}
+
+/* Multiply NUM by 10 to the power PLACES (divide if PLACES is negative)
+   and put the result, truncated or padded with zeros to SCALE places, in
+   RESULT.  This gives what multiplying or dividing by the power of ten
+   would, in time linear in the length of NUM. */
+
+void bc_shift_scale (bc_num num, int places, int scale, bc_num *result)
+{
+  bc_num temp;
+  int newlen, lead, count;
+
+  if (scale < 0)
+    scale = 0;
+  newlen = num->n_len + places;
+  lead = (newlen < 1) ? 1 - newlen : 0;     /* zeros in front */
+  count = MIN(num->n_len + num->n_scale, newlen + scale);
+
+  temp = bc_new_num (newlen + lead, scale);
+  if (count > 0)
+    memcpy (temp->n_value + lead, num->n_value, count);
+  temp->n_sign = num->n_sign;
+  _bc_rm_leading_zeros (temp);
+  if (bc_is_zero (temp))
+    temp->n_sign = PLUS;
+
+  bc_free_num (result);
+  *result = temp;
+}
+
+/* A stack of digits for bc_out_num. */
+
+typedef struct stk_rec {
+	long  digit;
+	struct stk_rec *next;
+} stk_rec;
+
+/* The reference string for digits. */
+static const char ref_str[] = "0123456789ABCDEF";
+
+/* A special output routine for "multi-character digits."  Exactly
+   SIZE characters must be output for the value VAL.  If SPACE is
+   non-zero, we must output one space before the number.  OUT_CHAR
+   is the actual routine for writing the characters. */
+
+static void bc_out_long (long val, int size, int space, void (*out_char)(int))
+{
+  char digits[12];
+  int len;
+
+  if (space) (*out_char) (' ');
+  len = 0;
+  do
+    {
+      digits[len++] = BCD_CHAR (val % 10);
+      val /= 10;
+    }
+  while (val > 0);
+  while (size > len)
+    {
+      (*out_char) ('0');
+      size--;
+    }
+  while (len > 0)
+    (*out_char) (digits[--len]);
+}
+
+/* Output of a bcd number.  NUM is written in base O_BASE using OUT_CHAR
+   as the routine to do the actual output of the characters.  Bases over
+   16 have each digit written as a decimal number after a space.  If
+   LEADING_ZERO is non-zero a zero is written before the point of a
+   number less than one. */
+
+void bc_out_num (bc_num num, int o_base, void (*out_char)(int), int leading_zero)
+{
+  char *nptr;
+  int  index, fdigit, pre_space;
+  stk_rec *digits, *temp;
+  bc_num int_part, frac_part, base, cur_dig, t_num, max_o_digit;
+
+  /* The negative sign if needed. */
+  if (num->n_sign == MINUS) (*out_char) ('-');
+
+  /* Output the number. */
+  if (bc_is_zero (num))
+    (*out_char) ('0');
+  else
+    if (o_base == 10)
+      {
+	/* The number is in base 10, do it the fast way. */
+	nptr = num->n_value;
+	if (num->n_len > 1 || *nptr != 0)
+	  for (index=num->n_len; index>0; index--)
+	    (*out_char) (BCD_CHAR(*nptr++));
+	else
+	  {
+	    nptr++;
+	    if (leading_zero)
+	      (*out_char) ('0');
+	  }
+
+	/* Now the fraction. */
+	if (num->n_scale > 0)
+	  {
+	    (*out_char) ('.');
+	    for (index=0; index<num->n_scale; index++)
+	      (*out_char) (BCD_CHAR(*nptr++));
+	  }
+      }
+    else
+      {
+	/* The number is some other base. */
+	digits = NULL;
+	bc_init_num (&int_part);
+	bc_divide (num, _one_, &int_part, 0);
+	bc_init_num (&frac_part);
+	bc_init_num (&cur_dig);
+	bc_init_num (&base);
+	bc_sub (num, int_part, &frac_part, 0);
+	/* Make the INT_PART and FRAC_PART positive. */
+	int_part->n_sign = PLUS;
+	frac_part->n_sign = PLUS;
+	bc_int2num (&base, o_base);
+	bc_init_num (&max_o_digit);
+	bc_int2num (&max_o_digit, o_base-1);
+
+	/* Get the digits of the integer part and push them on a stack. */
+	while (!bc_is_zero (int_part))
+	  {
+	    bc_modulo (int_part, base, &cur_dig, 0);
+	    temp = (stk_rec *) malloc (sizeof(stk_rec));
+	    if (temp == NULL) bc_out_of_memory();
+	    temp->digit = bc_num2long (cur_dig);
+	    temp->next = digits;
+	    digits = temp;
+	    bc_divide (int_part, base, &int_part, 0);
+	  }
+
+	/* Print the digits on the stack. */
+	if (digits == NULL && leading_zero)
+	  (*out_char) ('0');
+	pre_space = 0;
+	while (digits != NULL)
+	  {
+	    temp = digits;
+	    digits = digits->next;
+	    if (o_base <= 16)
+	      (*out_char) (ref_str[ (int) temp->digit]);
+	    else
+	      {
+		bc_out_long (temp->digit, max_o_digit->n_len, pre_space, out_char);
+		pre_space = 1;
+	      }
+	    free (temp);
+	  }
+
+	/* Get and print the digits of the fraction part. */
+	if (num->n_scale > 0)
+	  {
+	    (*out_char) ('.');
+	    pre_space = 0;
+	    t_num = bc_copy_num (_one_);
+	    while (t_num->n_len <= num->n_scale) {
+	      bc_multiply (frac_part, base, &frac_part, num->n_scale);
+	      fdigit = bc_num2long (frac_part);
+	      bc_int2num (&int_part, fdigit);
+	      bc_sub (frac_part, int_part, &frac_part, 0);
+	      if (o_base <= 16)
+		(*out_char) (ref_str[fdigit]);
+	      else {
+		bc_out_long (fdigit, max_o_digit->n_len, pre_space, out_char);
+		pre_space = 1;
+	      }
+	      bc_multiply (t_num, base, &t_num, 0);
+	    }
+	    bc_free_num (&t_num);
+	  }
+
+	/* Clean up. */
+	bc_free_num (&int_part);
+	bc_free_num (&frac_part);
+	bc_free_num (&base);
+	bc_free_num (&cur_dig);
+	bc_free_num (&max_o_digit);
+      }
+}
+
 /* Added by NJG to remove a memory leak */
 
 void
@@ -1506,9 +2257,24 @@ bc_free_numbers (void)
 
 }
 
-// error handler - replace this for different error handling
+static bc_error_handler error_handler = NULL;
+
+// Have handler called for errors and warnings, returning the previous one.
+// Set it before starting any other threads.
+bc_error_handler bc_set_error_handler (bc_error_handler handler)
+{
+  bc_error_handler old_handler = error_handler;
+  error_handler = handler;
+  return old_handler;
+} // end of bc_set_error_handler
+
+// error handler - use bc_set_error_handler for different error handling
+// The calculation cannot go on after an error, so if the handler returns
+// from one (rather than, say, restarting) this stops here.
 void bc_error (const int mesg)
 {
+  if (error_handler != NULL)
+    error_handler (mesg);
   // warnings are negative
   if (mesg >= 0)
     while (1) // some IDEs don't have the exit() function
@@ -31,15 +31,42 @@
 
 #ifndef _NUMBER_H_
 #define _NUMBER_H_
+
+#include <stddef.h>
   
 // errors, warnings
 
 #define BC_ERROR_OUT_OF_MEMORY 0
 #define BC_ERROR_EXPONENT_TOO_LARGE_IN_RAISE 1
+#define BC_ERROR_RESULT_TOO_LARGE 2
 #define BC_WARNING_NON_ZERO_SCALE_IN_EXPONENT -1
 #define BC_WARNING_NON_ZERO_SCALE_IN_BASE -2
 #define BC_WARNING_NON_ZERO_SCALE_IN_MODULUS -3
 
+// results of bc_parse_num
+
+#define BC_PARSE_OK 0
+#define BC_PARSE_NO_DIGITS 1    /* nothing that looks like a number */
+#define BC_PARSE_TRAILING 2     /* a number, followed by something else */
+#define BC_PARSE_RANGE 3        /* the exponent is too large */
+
+// what bc_parse_num accepts as well as plain numbers
+
+#define BC_PARSE_UNDERSCORES 1  /* 1_000_000 */
+#define BC_PARSE_EXPONENT 2     /* 1.5e-7 */
+
+// Set BIGNUMBER_THREADS to 1 (eg. with -DBIGNUMBER_THREADS=1) to use numbers
+// from more than one thread: reference counts are then changed atomically,
+// and the scale belongs to each thread.  It is on by default for the ESP32.
+
+#ifndef BIGNUMBER_THREADS
+ #if defined(ESP32) || defined(ARDUINO_ARCH_ESP32)
+  #define BIGNUMBER_THREADS 1
+ #else
+  #define BIGNUMBER_THREADS 0
+ #endif
+#endif
+
 
 typedef enum {PLUS, MINUS} sign;
 
@@ -62,6 +89,23 @@ typedef struct bc_struct
     } bc_struct;
 
 
+/* A division done a piece at a time (see bc_divide_start). */
+
+typedef struct bc_divide_state
+    {
+      bc_num qval;		/* The quotient so far. */
+      unsigned char *qptr;	/* Where its next digit goes. */
+      unsigned int qdig;	/* The quotient digits done so far, */
+      unsigned int qlast;	/* out of this many. */
+      unsigned char *num1;	/* The dividend, less what has been taken off. */
+      unsigned char *num2;	/* The divisor (normalized), */
+      unsigned char *n2ptr;	/* its first digit, */
+      unsigned int len2;	/* and its length from there. */
+      unsigned char *mval;	/* Room for the divisor times a digit. */
+      sign qsign;		/* The sign of the quotient. */
+    } bc_divide_state;
+
+
 /* The base used in storing the numbers in n_value above.
    Currently this MUST be 10. */
 
@@ -108,6 +152,24 @@ _PROTOTYPE(void bc_init_numbers, (void));
 
 _PROTOTYPE(void bc_free_numbers, (void));
 
+/* The error handler is called with the BC_ERROR or BC_WARNING number
+   above.  It may return from a warning (which is negative), but must not
+   return from an error (it can restart, or longjmp out): the calculation
+   cannot go on, so if the handler returns, bc_error never does. */
+typedef void (* bc_error_handler) (int mesg);
+_PROTOTYPE(bc_error_handler bc_set_error_handler, (bc_error_handler handler));
+
+/* Long loops call bc_poll, which calls the thread's poll handler with how
+   far the outermost of them has got (done out of total, or a total of zero
+   if that is not known).  If the handler returns nonzero the loops give up,
+   and their results mean nothing, until a handler is set again. */
+typedef int (* bc_poll_handler) (void *context, long done, long total);
+_PROTOTYPE(void bc_set_poll_handler, (bc_poll_handler handler, void *context));
+_PROTOTYPE(int bc_poll, (long done, long total));
+_PROTOTYPE(void bc_poll_enter, (void));
+_PROTOTYPE(void bc_poll_leave, (void));
+_PROTOTYPE(int bc_poll_stopped, (void));
+
 _PROTOTYPE(bc_num bc_new_num, (int length, int scale));
 
 _PROTOTYPE(void bc_free_num, (bc_num *num));
@@ -118,6 +180,9 @@ _PROTOTYPE(void bc_init_num, (bc_num *num));
 
 _PROTOTYPE(void bc_str2num, (bc_num *num, const char *str, int scale));
 
+_PROTOTYPE(int bc_parse_num, (bc_num *num, const char *str, size_t length,
+			     int scale, int flags, size_t *consumed));
+
 _PROTOTYPE(char *bc_num2str, (bc_num num));
 
 _PROTOTYPE(void bc_int2num, (bc_num *num, int val));
@@ -140,6 +205,15 @@ _PROTOTYPE(void bc_multiply, (bc_num n1, bc_num n2, bc_num *prod, int scale));
 
 _PROTOTYPE(int bc_divide, (bc_num n1, bc_num n2, bc_num *quot, int scale));
 
+_PROTOTYPE(int bc_divide_start, (bc_divide_state *st, bc_num n1, bc_num n2,
+				 int scale));
+
+_PROTOTYPE(int bc_divide_step, (bc_divide_state *st, long *budget));
+
+_PROTOTYPE(void bc_divide_finish, (bc_divide_state *st, bc_num *quot));
+
+_PROTOTYPE(void bc_divide_abandon, (bc_divide_state *st));
+
 _PROTOTYPE(int bc_modulo, (bc_num num1, bc_num num2, bc_num *result,
 			   int scale));
 
@@ -154,6 +228,11 @@ _PROTOTYPE(void bc_raise, (bc_num num1, bc_num num2, bc_num *result,
 
 _PROTOTYPE(int bc_sqrt, (bc_num *num, int scale));
 
+_PROTOTYPE(void bc_shift_num, (bc_num num, int places, bc_num *result));
+
+_PROTOTYPE(void bc_shift_scale, (bc_num num, int places, int scale,
+			       bc_num *result));
+
 _PROTOTYPE(void bc_out_num, (bc_num num, int o_base, void (* out_char)(int),
 			     int leading_zero));
 